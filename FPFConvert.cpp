@@ -0,0 +1,81 @@
+// Converts the `trk` tree of an FPFSim output file to a CompactEventFile,
+// which FPFDisplay opens like the original for faster browsing.
+//
+// Usage: FPFConvert <in.root> [out.fpfevd] [--precision-um U]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TSystem.h"
+
+#include "CompactEventFile.hh"
+#include "EventData.hh"
+#include "EventIndex.hh"
+#include "EventReader.hh"
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args;
+    double precisionUm = 10;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--precision-um" && i+1 < argc) precisionUm = std::atof(argv[++i]);
+        else args.push_back(arg);
+    }
+    if (args.empty() || args.size() > 2 || precisionUm <= 0) {
+        std::cerr << "Usage: " << argv[0] << " <in.root> [out.fpfevd] [--precision-um U]\n";
+        return 1;
+    }
+    const std::string input = args[0];
+    std::string output = args.size() > 1 ? args[1] : input;
+    if (args.size() == 1) {
+        if (output.size() > 5 && output.compare(output.size() - 5, 5, ".root") == 0) output.resize(output.size() - 5);
+        output += ".fpfevd";
+    }
+
+    EventReader reader;
+    EventIndex index;
+    if (!reader.Open(input)) return 1;
+    if (!reader.GetFile()) {
+        std::cerr << input << " is already a compact file\n";
+        return 1;
+    }
+    if (!reader.BuildIndex(index)) {
+        std::cerr << "No events in " << input << std::endl;
+        return 1;
+    }
+
+    // points are kept to half the step, 10 um -> 5 um at most. The output
+    // only appears once complete: a failed conversion leaves no partial file
+    CompactEventWriter writer;
+    if (!writer.Open(output, precisionUm * 1e-4)) return 1;
+
+    auto start = std::chrono::steady_clock::now();
+    EventData data;
+    double maxError = 0;
+    Long64_t nPoints = 0;
+    for (int evtID : index.GetEventIDs()) {
+        if (!reader.ReadEvent(*index.Find(evtID), data)) return 1;
+        const double error = writer.AddEvent(data);
+        if (error < 0) return 1;
+        maxError = std::max(maxError, error);
+        nPoints += data.NPoints();
+    }
+    if (!writer.Close()) return 1;
+    auto s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Long64_t inSize = 0;
+    FileStat_t st;
+    if (gSystem->GetPathInfo(input.c_str(), st) == 0) inSize = st.fSize;
+    const Long64_t outSize = writer.GetBytes();
+    std::cout << "Converted " << index.Size() << " events (" << nPoints << " points) in " << s << " s to " << output << "\n"
+              << "Size: " << inSize / 1048576. << " MB -> " << outSize / 1048576. << " MB ("
+              << (outSize > 0 ? double(inSize) / outSize : 0.) << "x smaller), "
+              << (nPoints > 0 ? double(outSize) / nPoints : 0.) << " bytes/point\n"
+              << "Largest point error: " << maxError * 1e4 << " um" << std::endl;
+    return 0;
+}
@@ -1,24 +1,175 @@
+#include "EventChain.hh"
+#include "EventReader.hh"
+#include "EventSelection.hh"
 #include "GUIDisplay.hh"
+#include "RenderPool.hh"
+#include "StageTimer.hh"
 #include "TApplication.h"
+#include "TSystem.h"
 #include <iostream>
+#include <cstdlib>
+#include <sstream>
+#include <unistd.h>
+
+// The GL viewers need a GL context even when rendering off-screen:
+// without an X server, run again inside a virtual one if available
+static void ReexecUnderXvfb(int argc, char** argv)
+{
+    if (gSystem->Getenv("DISPLAY") || gSystem->Getenv("FPFDISPLAY_XVFB")) return;
+
+    char* xvfb = gSystem->Which(gSystem->Getenv("PATH"), "xvfb-run");
+    if (!xvfb) {
+        std::cerr << "No DISPLAY and no xvfb-run found, rendering will most likely fail\n";
+        return;
+    }
+
+    std::vector<char*> xargs = {xvfb, (char*) "-a", (char*) "-s", (char*) "-screen 0 1920x1080x24"};
+    xargs.insert(xargs.end(), argv, argv + argc);
+    xargs.push_back(nullptr);
+    gSystem->Setenv("FPFDISPLAY_XVFB", "1");
+    std::cout << "No DISPLAY, rendering inside " << xvfb << std::endl;
+    execv(xvfb, xargs.data());
+    std::cerr << "Failed to run " << xvfb << "\n";
+    delete[] xvfb;
+}
 
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <gdmlfile> [rootfile]\n";
+
+    // split options from positional arguments
+    std::vector<std::string> args;
+    int cacheMB = 256;
+    int prefetch = 2;
+    int maxOpenFiles = 16;
+    Long64_t chunkVertices = 100000;
+    Long64_t maxVertices = 5000000;
+    ReadOptions readOptions;
+    std::string styleFile;
+    GeometryLOD lod;
+    std::vector<Long64_t> budgets;
+    std::vector<std::string> detectors;
+    bool headless = false;
+    std::string eventSpec = "all";
+    std::string outputPattern = "evd_%d.png";
+    int scale = 1;
+    int workers = 1;
+    bool tiled = false;
+    std::string timingLog;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cache-mb" && i+1 < argc) cacheMB = std::atoi(argv[++i]);
+        else if (arg == "--prefetch" && i+1 < argc) prefetch = std::atoi(argv[++i]);
+        else if (arg == "--max-open-files" && i+1 < argc) maxOpenFiles = std::atoi(argv[++i]);
+        else if (arg == "--chunk-vertices" && i+1 < argc) chunkVertices = std::atoll(argv[++i]);
+        else if (arg == "--max-vertices" && i+1 < argc) maxVertices = std::atoll(argv[++i]);
+        else if (arg == "--tree-cache-mb" && i+1 < argc) readOptions.cacheBytes = Long64_t(std::atoi(argv[++i])) << 20;
+        else if (arg == "--no-prefill") readOptions.prefill = false;
+        else if (arg == "--unzip-threads" && i+1 < argc) readOptions.unzipThreads = std::atoi(argv[++i]);
+        else if (arg == "--io-stats") readOptions.stats = true;
+        else if (arg == "--geo-style" && i+1 < argc) styleFile = argv[++i];
+        else if (arg == "--geo-min-size" && i+1 < argc) lod.minSize = std::atof(argv[++i]);
+        else if (arg == "--geo-merge" && i+1 < argc) lod.mergeRepeated = std::atoi(argv[++i]);
+        else if (arg == "--geo-segments" && i+1 < argc) lod.nSegments = std::atoi(argv[++i]);
+        else if (arg == "--geo-depth" && i+1 < argc) lod.maxDepth = std::atoi(argv[++i]);
+        else if (arg == "--detectors" && i+1 < argc) {
+            std::stringstream list(argv[++i]);
+            for (std::string d; std::getline(list, d, ','); ) detectors.push_back(d);
+        }
+        else if (arg == "--tri-budget" && i+1 < argc) {
+            // one budget for all viewers, or 3D,ZX,ZY
+            std::stringstream list(argv[++i]);
+            for (std::string b; std::getline(list, b, ','); ) budgets.push_back(std::atoll(b.c_str()));
+        }
+        else if (arg == "--tiled") tiled = true;
+        else if (arg == "--headless") headless = true;
+        else if (arg == "--events" && i+1 < argc) eventSpec = argv[++i];
+        else if (arg == "--output" && i+1 < argc) outputPattern = argv[++i];
+        else if (arg == "--scale" && i+1 < argc) scale = std::atoi(argv[++i]);
+        else if (arg == "--workers" && i+1 < argc) workers = std::atoi(argv[++i]);
+        else if (arg == "--timing-log" && i+1 < argc) timingLog = argv[++i];
+        else args.push_back(arg);
+    }
+
+    if (args.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <gdmlfile> [rootfile|'pattern*.root' ...] [--cache-mb N] [--prefetch K]\n"
+                  << "       [--max-open-files N] [--chunk-vertices N] [--max-vertices N] [--geo-style FILE]\n"
+                  << "       [--tree-cache-mb N] [--no-prefill] [--unzip-threads N] [--io-stats]\n"
+                  << "       [--geo-min-size CM] [--geo-merge N] [--geo-segments N] [--geo-depth N] [--tri-budget N|N3D,NZX,NZY]\n"
+                  << "       [--detectors FLArE,FASER2,FASERnu2,FORMOSA,BabyMIND,Other] [--tiled] [--timing-log FILE]\n"
+                  << "       [--headless [--events all|ID,FIRST-LAST,...|@FILE] [--output evd_%d.png] [--scale N] [--workers N]]\n";
         return 1;
     }
-    std::string gdmlFile = argv[1];
-    std::string rootFile = (argc > 2) ? argv[2] : "";
+    std::string gdmlFile = args[0];
+    std::vector<std::string> rootFiles = EventChain::Expand(std::vector<std::string>(args.begin() + 1, args.end()));
+
+    if (headless && rootFiles.empty()) {
+        std::cerr << "Headless rendering needs a data file\n";
+        return 1;
+    }
+    if (headless) ReexecUnderXvfb(argc, argv);
+    if (!timingLog.empty()) StageStats::Instance().SetLogFile(timingLog);
+
+    // also run by each rendering worker after forking: the implicit-MT
+    // pool of --unzip-threads must not be started before
+    auto configure = [&](GUIDisplay& gui) {
+        EventReader::SetOptions(readOptions);
+        if (!styleFile.empty()) gui.SetGeometryStyle(styleFile);
+        gui.SetGeometryLOD(lod);
+        gui.SetDetectors(detectors);
+        gui.SetTiledExport(tiled);
+        if (budgets.size() == 1) gui.SetTriangleBudgets(budgets[0], budgets[0], budgets[0]);
+        else if (budgets.size() == 3) gui.SetTriangleBudgets(budgets[0], budgets[1], budgets[2]);
+        else if (!budgets.empty()) std::cerr << "Ignoring --tri-budget: expected 1 or 3 values\n";
+        gui.LoadGeometry(gdmlFile, false);
+
+        if (!rootFiles.empty()) {
+            gui.SetCacheOptions(cacheMB, prefetch, maxOpenFiles);
+            gui.SetBuildOptions(chunkVertices, maxVertices);
+            gui.LoadFiles(rootFiles);
+        }
+    };
+
+    // events to render, file by file
+    auto selectEvents = [&]() {
+        std::vector<EventRef> events;
+        for (std::size_t f = 0; f < rootFiles.size(); ++f) {
+            for (int evtID : SelectEvents(eventSpec, DataManager::ReadEventList(rootFiles[f])))
+                events.push_back({(int) f, evtID});
+        }
+        return events;
+    };
+
+    // several processes, each with its own display: nothing ROOT GUI related
+    // may be created before forking
+    if (headless && workers > 1) {
+        // the pool hands out evtIDs with one file, positions in `selected` with several
+        std::vector<EventRef> selected = selectEvents();
+        std::vector<int> events;
+        for (std::size_t i = 0; i < selected.size(); ++i)
+            events.push_back(rootFiles.size() > 1 ? (int) i : selected[i].evtID);
+        GUIDisplay* gui = nullptr;
+        auto setup = [&]() {
+            new TApplication("FPFDisplay", &argc, argv);
+            gui = new GUIDisplay();
+            configure(*gui);
+            gui->Initialize("FPF Event Display", true);
+            return true;
+        };
+        auto render = [&](int job) {
+            return gui->RenderEvent(rootFiles.size() > 1 ? selected[job] : EventRef{0, job}, outputPattern, scale);
+        };
+        return RenderPool(workers).Run(events, setup, render) == 0 ? 0 : 2;
+    }
 
     TApplication app("FPFDisplay", &argc, argv);
 
     GUIDisplay gui;
     try {
-        
-        gui.LoadGeometry(gdmlFile, false);
-        
-        if (!rootFile.empty()) {
-            gui.LoadFile(rootFile);
+        configure(gui);
+
+        if (headless) {
+            std::vector<EventRef> events = selectEvents();
+            gui.Initialize("FPF Event Display", true);
+            return gui.RenderEvents(events, outputPattern, scale) == 0 ? 0 : 2;
         }
 
         gui.Initialize("FPF Event Display");
@@ -0,0 +1,284 @@
+// Times the data path behind DataManager, without any display:
+// opening and indexing a file, loading a single event, and stepping
+// through events in order and at random through the prefetch cache,
+// the way "Prev."/"Next" and jumps do. With --compact, the same events
+// are also decoded from the FPFConvert copy of the file, to compare.
+// Results are written as one JSON document, to compare releases.
+//
+// Usage: BenchEventNavigation <datafile.root> [--repeat N] [--steps N]
+//        [--prefetch K] [--cache-mb N] [--think MS] [--seed S] [--json FILE]
+//        [--tree-cache-mb N] [--no-prefill] [--unzip-threads N] [--compact FILE]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TROOT.h"
+#include "TSystem.h"
+
+#include "EventCache.hh"
+#include "EventData.hh"
+#include "EventIndex.hh"
+#include "EventReader.hh"
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double Since(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    /// Timings of one benchmark, in ms
+    struct Result {
+        std::string name;
+        std::vector<double> samples;
+        std::string extra; // more JSON members, without the leading comma
+
+        std::string ToJSON() const
+        {
+            std::vector<double> s = samples;
+            std::sort(s.begin(), s.end());
+            auto pct = [&](double q) { return s.empty() ? 0. : s[std::min(s.size() - 1, std::size_t(q * s.size()))]; };
+            double sum = 0;
+            for (double v : s) sum += v;
+
+            std::ostringstream ss;
+            ss << "{\"name\":\"" << name << "\",\"unit\":\"ms\",\"n\":" << s.size()
+               << ",\"mean\":" << (s.empty() ? 0. : sum / s.size())
+               << ",\"min\":" << (s.empty() ? 0. : s.front())
+               << ",\"p50\":" << pct(0.5) << ",\"p90\":" << pct(0.9) << ",\"p99\":" << pct(0.99)
+               << ",\"max\":" << (s.empty() ? 0. : s.back());
+            if (!extra.empty()) ss << "," << extra;
+            ss << "}";
+            return ss.str();
+        }
+    };
+
+    /// Same neighbours as DataManager::RequestPrefetch: next events first
+    void Prefetch(EventCache& cache, const EventIndex& index, const std::vector<int>& ids, int pos, int depth)
+    {
+        std::vector<EventCache::Request> todo;
+        for (int d = 1; d <= depth; ++d)
+            if (pos + d < (int) ids.size()) todo.push_back({0, *index.Find(ids[pos + d])});
+        for (int d = 1; d <= depth; ++d)
+            if (pos - d >= 0) todo.push_back({0, *index.Find(ids[pos - d])});
+        cache.Prefetch(todo);
+    }
+
+    /// Visit the events at the given positions as DataManager::LoadEvent does:
+    /// cached event or decode it here, then queue the neighbours
+    Result Navigate(const std::string& name, const std::string& filename, EventReader& reader,
+                    const EventIndex& index, const std::vector<int>& ids, const std::vector<int>& order,
+                    int prefetch, int cacheMB, int thinkMs)
+    {
+        EventCache cache;
+        cache.SetCapacity(cacheMB);
+        cache.Start({filename});
+
+        Result result{name, {}, ""};
+        long nPoints = 0;
+        long long bytesRead = 0, readCalls = 0;
+        for (int pos : order) {
+            auto start = Clock::now();
+            std::shared_ptr<const EventData> data = cache.Get({0, ids[pos]});
+            if (!data) {
+                auto decoded = std::make_shared<EventData>();
+                if (!reader.ReadEvent(*index.Find(ids[pos]), *decoded)) break;
+                cache.Put(decoded);
+                data = decoded;
+            }
+            Prefetch(cache, index, ids, pos, prefetch);
+            result.samples.push_back(Since(start));
+            nPoints += data->NPoints();
+            bytesRead += data->bytesRead;
+            readCalls += data->readCalls;
+
+            // the time a shifter looks at the event, for the prefetching to catch up
+            if (thinkMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(thinkMs));
+        }
+        cache.Stop();
+
+        std::ostringstream ss;
+        ss << "\"hits\":" << cache.GetHits() << ",\"misses\":" << cache.GetMisses()
+           << ",\"points\":" << nPoints << ",\"bytesRead\":" << bytesRead << ",\"readCalls\":" << readCalls;
+        result.extra = ss.str();
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args;
+    int repeat = 5;
+    int steps = 200;
+    int prefetch = 2;
+    int cacheMB = 256;
+    int thinkMs = 0;
+    unsigned seed = 12345;
+    std::string jsonFile;
+    std::string compactFile;
+    ReadOptions readOptions;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--repeat" && i+1 < argc) repeat = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--steps" && i+1 < argc) steps = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--prefetch" && i+1 < argc) prefetch = std::atoi(argv[++i]);
+        else if (arg == "--cache-mb" && i+1 < argc) cacheMB = std::atoi(argv[++i]);
+        else if (arg == "--think" && i+1 < argc) thinkMs = std::atoi(argv[++i]);
+        else if (arg == "--seed" && i+1 < argc) seed = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--json" && i+1 < argc) jsonFile = argv[++i];
+        else if (arg == "--tree-cache-mb" && i+1 < argc) readOptions.cacheBytes = Long64_t(std::atoi(argv[++i])) << 20;
+        else if (arg == "--no-prefill") readOptions.prefill = false;
+        else if (arg == "--unzip-threads" && i+1 < argc) readOptions.unzipThreads = std::atoi(argv[++i]);
+        else if (arg == "--compact" && i+1 < argc) compactFile = argv[++i];
+        else args.push_back(arg);
+    }
+    if (args.size() != 1) {
+        std::cerr << "Usage: " << argv[0] << " <datafile.root> [--repeat N] [--steps N]\n"
+                  << "       [--prefetch K] [--cache-mb N] [--think MS] [--seed S] [--json FILE]\n"
+                  << "       [--tree-cache-mb N] [--no-prefill] [--unzip-threads N] [--compact FILE]\n";
+        return 1;
+    }
+    readOptions.stats = readOptions.unzipThreads == 0;
+    EventReader::SetOptions(readOptions);
+    const std::string filename = args[0];
+    std::vector<Result> results;
+
+    // open and index, from scratch and from the sidecar index
+    Result open{"file.open", {}, ""}, build{"file.index.build", {}, ""}, load{"file.index.load", {}, ""};
+    EventReader reader;
+    EventIndex index;
+    for (int r = 0; r < repeat; ++r) {
+        reader.Close();
+        auto start = Clock::now();
+        if (!reader.Open(filename)) return 1;
+        open.samples.push_back(Since(start));
+
+        start = Clock::now();
+        if (!reader.BuildIndex(index)) {
+            std::cerr << "No events in " << filename << std::endl;
+            return 1;
+        }
+        build.samples.push_back(Since(start));
+
+        EventIndex::Key key = EventIndex::MakeKey(reader.GetFile(), filename);
+        std::string sidecar = EventIndex::SidecarPath(key);
+        if (!sidecar.empty() && index.Save(sidecar, key)) {
+            start = Clock::now();
+            if (index.Load(sidecar, key)) load.samples.push_back(Since(start));
+        }
+    }
+    results.push_back(open);
+    results.push_back(build);
+    results.push_back(load);
+
+    const std::vector<int> ids = index.GetEventIDs();
+    const int nSteps = std::min<int>(steps, ids.size());
+    std::cerr << "Benchmarking " << filename << ": " << ids.size() << " events" << std::endl;
+
+    // a single event, decoded without any cache, each time on a freshly opened file
+    Result single{"event.load.cold", {}, ""}, warm{"event.load.warm", {}, ""};
+    EventData data;
+    std::ostringstream coldIO; // of the last cold load
+    for (int r = 0; r < repeat; ++r) {
+        if (!reader.Open(filename)) return 1;
+        const EventIndex::Entry& entry = *index.Find(ids[(r * ids.size()) / repeat]);
+        auto start = Clock::now();
+        if (!reader.ReadEvent(entry, data)) return 1;
+        single.samples.push_back(Since(start));
+        coldIO.str("");
+        coldIO << ",\"bytesRead\":" << data.bytesRead << ",\"readCalls\":" << data.readCalls << ",\"unzipMs\":" << data.unzipMs;
+
+        start = Clock::now();
+        if (!reader.ReadEvent(entry, data)) return 1;
+        warm.samples.push_back(Since(start));
+    }
+    std::ostringstream size;
+    size << "\"tracks\":" << data.NTracks() << ",\"points\":" << data.NPoints();
+    single.extra = warm.extra = size.str();
+    single.extra += coldIO.str();
+    results.push_back(single);
+    results.push_back(warm);
+
+    // the first events in order, from the ROOT file then from its compact copy:
+    // all that a "Next" waits for, points, track quantities and significances
+    if (!compactFile.empty()) {
+        EventReader compactReader;
+        EventIndex compactIndex;
+        if (!compactReader.Open(compactFile) || !compactReader.BuildIndex(compactIndex)) {
+            std::cerr << "Cannot read " << compactFile << std::endl;
+            return 1;
+        }
+        Result fromRoot{"event.decode.root", {}, ""}, fromCompact{"event.decode.compact", {}, ""};
+        long nPoints = 0;
+        long long rootBytes = 0, compactBytes = 0;
+        for (int i = 0; i < nSteps; ++i) {
+            const EventIndex::Entry* entry = compactIndex.Find(ids[i]);
+            if (!entry) continue;
+            auto start = Clock::now();
+            if (!reader.ReadEvent(*index.Find(ids[i]), data)) return 1;
+            fromRoot.samples.push_back(Since(start));
+            rootBytes += data.bytesRead;
+
+            start = Clock::now();
+            if (!compactReader.ReadEvent(*entry, data)) return 1;
+            fromCompact.samples.push_back(Since(start));
+            compactBytes += data.bytesRead;
+            nPoints += data.NPoints();
+        }
+        std::ostringstream rootExtra, compactExtra;
+        rootExtra << "\"points\":" << nPoints << ",\"bytesRead\":" << rootBytes;
+        compactExtra << "\"points\":" << nPoints << ",\"bytesRead\":" << compactBytes;
+        fromRoot.extra = rootExtra.str();
+        fromCompact.extra = compactExtra.str();
+        results.push_back(fromRoot);
+        results.push_back(fromCompact);
+    }
+
+    // "Next" from the first event, then jumps to random events
+    std::vector<int> order(nSteps);
+    for (int i = 0; i < nSteps; ++i) order[i] = i;
+    results.push_back(Navigate("navigate.sequential", filename, reader, index, ids, order, prefetch, cacheMB, thinkMs));
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, ids.size() - 1);
+    for (int& pos : order) pos = pick(rng);
+    results.push_back(Navigate("navigate.random", filename, reader, index, ids, order, prefetch, cacheMB, thinkMs));
+
+    // one document: the parameters, then one object per benchmark
+    std::ostringstream json;
+    json << "{\"benchmark\":\"BenchEventNavigation\",\"file\":\"" << filename << "\""
+         << ",\"root\":\"" << gROOT->GetVersion() << "\",\"host\":\"" << gSystem->HostName() << "\""
+         << ",\"time\":" << std::time(nullptr) << ",\"events\":" << ids.size()
+         << ",\"repeat\":" << repeat << ",\"steps\":" << nSteps << ",\"prefetch\":" << prefetch
+         << ",\"cacheMB\":" << cacheMB << ",\"thinkMs\":" << thinkMs << ",\"seed\":" << seed
+         << ",\"treeCacheMB\":" << (readOptions.cacheBytes >> 20) << ",\"prefill\":" << (readOptions.prefill ? "true" : "false")
+         << ",\"unzipThreads\":" << readOptions.unzipThreads << ",\"compact\":\"" << compactFile << "\""
+         << ",\"results\":[";
+    for (std::size_t i = 0; i < results.size(); ++i)
+        json << (i ? ",\n  " : "\n  ") << results[i].ToJSON();
+    json << "\n]}\n";
+
+    if (jsonFile.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream out(jsonFile);
+        out << json.str();
+        if (!out) {
+            std::cerr << "Cannot write " << jsonFile << std::endl;
+            return 1;
+        }
+        std::cerr << "Results written to " << jsonFile << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,222 @@
+// Times the geometry startup of the display, stage by stage: GDML key,
+// import, styling and gentle extraction of each detector, loading of the
+// extracts and their ZX/ZY projections, triangle budgets, first redraw;
+// with the resident memory after each step and the peak. Results are
+// written as JSON.
+// The viewers need an X server, use xvfb-run without one.
+//
+// Usage: BenchGeometryLoading <geometry.gdml> [--cold] [--detectors LIST]
+//        [--geo-min-size CM] [--geo-merge N] [--geo-segments N] [--geo-depth N]
+//        [--tri-budget N|N3D,NZX,NZY] [--json FILE]
+//   --cold  extract into an empty cache directory, removed at the end
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "TApplication.h"
+#include "TEveGeoShape.h"
+#include "TEveManager.h"
+#include "TROOT.h"
+#include "TSystem.h"
+
+#include "GeometryBudget.hh"
+#include "GeometryManager.hh"
+#include "MultiView.hh"
+#include "StageTimer.hh"
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    /// One timed step and the memory after it
+    struct Step {
+        std::string name;
+        double ms;
+        double rssMB;
+        long shapes; // drawable shapes added by the step, -1 if not relevant
+    };
+
+    double ResidentMB()
+    {
+        ProcInfo_t info;
+        gSystem->GetProcInfo(&info);
+        return info.fMemResident / 1024.;
+    }
+
+    double PeakResidentMB()
+    {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / 1024.; // kB on Linux
+    }
+
+    long CountShapes(TEveElement* el)
+    {
+        long n = dynamic_cast<TEveGeoShape*>(el) ? 1 : 0;
+        for (auto it = el->BeginChildren(); it != el->EndChildren(); ++it) n += CountShapes(*it);
+        return n;
+    }
+
+    void RemoveDirectory(const std::string& dir)
+    {
+        void* d = gSystem->OpenDirectory(dir.c_str());
+        if (!d) return;
+        while (const char* entry = gSystem->GetDirEntry(d)) {
+            std::string name = entry;
+            if (name != "." && name != "..") gSystem->Unlink((dir + "/" + name).c_str());
+        }
+        gSystem->FreeDirectory(d);
+        gSystem->Unlink(dir.c_str());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args;
+    bool cold = false;
+    std::vector<std::string> detectors;
+    GeometryLOD lod;
+    std::vector<Long64_t> budgets;
+    std::string jsonFile = "geometry_bench.json";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cold") cold = true;
+        else if (arg == "--detectors" && i+1 < argc) {
+            std::stringstream list(argv[++i]);
+            for (std::string d; std::getline(list, d, ','); ) detectors.push_back(d);
+        }
+        else if (arg == "--geo-min-size" && i+1 < argc) lod.minSize = std::atof(argv[++i]);
+        else if (arg == "--geo-merge" && i+1 < argc) lod.mergeRepeated = std::atoi(argv[++i]);
+        else if (arg == "--geo-segments" && i+1 < argc) lod.nSegments = std::atoi(argv[++i]);
+        else if (arg == "--geo-depth" && i+1 < argc) lod.maxDepth = std::atoi(argv[++i]);
+        else if (arg == "--tri-budget" && i+1 < argc) {
+            // one budget for all viewers, or 3D,ZX,ZY
+            std::stringstream list(argv[++i]);
+            for (std::string b; std::getline(list, b, ','); ) budgets.push_back(std::atoll(b.c_str()));
+        }
+        else if (arg == "--json" && i+1 < argc) jsonFile = argv[++i];
+        else args.push_back(arg);
+    }
+    if (budgets.size() == 1) budgets.assign(3, budgets[0]);
+    if (args.size() != 1 || (!budgets.empty() && budgets.size() != 3)) {
+        std::cerr << "Usage: " << argv[0] << " <geometry.gdml> [--cold] [--detectors LIST]\n"
+                  << "       [--geo-min-size CM] [--geo-merge N] [--geo-segments N] [--geo-depth N]\n"
+                  << "       [--tri-budget N|N3D,NZX,NZY] [--json FILE]\n";
+        return 1;
+    }
+    const std::string gdmlFile = args[0];
+    if (budgets.empty()) budgets.assign(3, 0);
+    if (detectors.empty())
+        for (const auto& d : GeometryManager::GetDetectors()) detectors.push_back(d.name);
+
+    // a fresh cache directory, so that every detector is extracted
+    std::string cacheDir;
+    if (cold) {
+        std::string tmpl = std::string(gSystem->TempDirectory()) + "/fpfdisplay-bench-XXXXXX";
+        if (!mkdtemp(&tmpl[0])) {
+            std::cerr << "Cannot create a temporary cache directory" << std::endl;
+            return 1;
+        }
+        cacheDir = tmpl;
+        gSystem->Setenv("FPFDISPLAY_CACHE_DIR", cacheDir.c_str());
+    }
+
+    std::vector<Step> steps;
+    const double startMB = ResidentMB();
+    auto total = Clock::now();
+    auto run = [&](const std::string& name, const std::function<long()>& step) {
+        auto start = Clock::now();
+        const long shapes = step();
+        steps.push_back({name, std::chrono::duration<double, std::milli>(Clock::now() - start).count(), ResidentMB(), shapes});
+    };
+
+    int appArgc = 1;
+    TApplication app("BenchGeometryLoading", &appArgc, argv);
+
+    GeometryManager geom;
+    GeometryBudget geomBudget;
+    Long64_t triangles[3] = {0, 0, 0}; // drawn in the 3D, ZX and ZY viewers
+    MultiView* mv = nullptr;
+    TEveElementList* geometry = nullptr;
+    TEveElement *geometryZX = nullptr, *geometryZY = nullptr;
+    try {
+        // the same sequence as GUIDisplay::Initialize, windows not mapped
+        run("eve.create", [&]() { TEveManager::Create(kFALSE); return -1L; });
+        run("multiview.create", [&]() {
+            mv = new MultiView();
+            geometry = new TEveElementList("Geometry");
+            gEve->AddGlobalElement(geometry);
+            geometryZX = mv->ImportGeomZX(geometry);
+            geometryZY = mv->ImportGeomZY(geometry);
+            return -1L;
+        });
+        run("gdml.key", [&]() { geom.SetLOD(lod); geom.LoadGDML(gdmlFile); return -1L; });
+
+        for (const std::string& detector : detectors) {
+            TEveElementList* gentle = nullptr;
+            run("gentle." + detector, [&]() {
+                gentle = geom.ImportGentleGeometry(detector);
+                return gentle ? CountShapes(gentle) : 0L;
+            });
+            if (!gentle) continue;
+            geometry->AddElement(gentle);
+            run("project." + detector, [&]() {
+                mv->ImportGeomZX(gentle, geometryZX);
+                mv->ImportGeomZY(gentle, geometryZY);
+                return 2 * CountShapes(gentle);
+            });
+            geomBudget.Add(gentle, lod.nSegments);
+        }
+        // as GUIDisplay::ApplyGeometryBudgets, the 3D budget first
+        run("budget", [&]() {
+            triangles[0] = geomBudget.Apply(geometry, budgets[0], "3D");
+            triangles[1] = geomBudget.Apply(geometryZX, budgets[1], "ZX");
+            triangles[2] = geomBudget.Apply(geometryZY, budgets[2], "ZY");
+            return -1L;
+        });
+        run("redraw", [&]() { gEve->FullRedraw3D(kTRUE); return -1L; });
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        if (!cacheDir.empty()) RemoveDirectory(cacheDir);
+        return 1;
+    }
+    const double totalMs = std::chrono::duration<double, std::milli>(Clock::now() - total).count();
+    if (!cacheDir.empty()) RemoveDirectory(cacheDir);
+
+    // the steps, then the finer stage timers of GeometryManager and MultiView
+    std::ostringstream json;
+    json << "{\"benchmark\":\"BenchGeometryLoading\",\"file\":\"" << gdmlFile << "\""
+         << ",\"root\":\"" << gROOT->GetVersion() << "\",\"host\":\"" << gSystem->HostName() << "\""
+         << ",\"time\":" << std::time(nullptr) << ",\"cold\":" << (cold ? "true" : "false")
+         << ",\"lod\":{\"minSize\":" << lod.minSize << ",\"mergeRepeated\":" << lod.mergeRepeated
+         << ",\"nSegments\":" << lod.nSegments << ",\"maxDepth\":" << lod.maxDepth << "}"
+         << ",\"budgets\":[" << budgets[0] << "," << budgets[1] << "," << budgets[2] << "]"
+         << ",\"triangles\":{\"3D\":" << triangles[0] << ",\"ZX\":" << triangles[1] << ",\"ZY\":" << triangles[2] << "}"
+         << ",\"totalMs\":" << totalMs << ",\"startRssMB\":" << startMB << ",\"peakRssMB\":" << PeakResidentMB()
+         << ",\"steps\":[";
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+        json << (i ? ",\n  " : "\n  ") << "{\"name\":\"" << steps[i].name << "\",\"ms\":" << steps[i].ms
+             << ",\"rssMB\":" << steps[i].rssMB;
+        if (steps[i].shapes >= 0) json << ",\"shapes\":" << steps[i].shapes;
+        json << "}";
+    }
+    json << "\n],\"stages\":" << StageStats::Instance().GetJSON() << "}\n";
+
+    std::ofstream out(jsonFile);
+    out << json.str();
+    if (!out) {
+        std::cerr << "Cannot write " << jsonFile << std::endl;
+        return 1;
+    }
+    std::cout << "Geometry loaded in " << totalMs << " ms, peak RSS " << PeakResidentMB() << " MB, results written to "
+              << jsonFile << std::endl;
+    return 0;
+}
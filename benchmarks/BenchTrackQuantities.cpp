@@ -0,0 +1,65 @@
+// Times the per-track quantities pass (ComputeTrackQuantities)
+// against the full decoding of the same events from an FPFSim file.
+//
+// Usage: BenchTrackQuantities <datafile.root> [maxEvents]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "EventData.hh"
+#include "EventIndex.hh"
+#include "EventReader.hh"
+#include "TrackQuantities.hh"
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <datafile.root> [maxEvents]\n";
+        return 1;
+    }
+    const std::string filename = argv[1];
+    const long maxEvents = (argc > 2) ? std::atol(argv[2]) : -1;
+
+    EventReader reader;
+    if (!reader.Open(filename)) return 1;
+
+    EventIndex index;
+    EventIndex::Key key = EventIndex::MakeKey(reader.GetFile(), filename);
+    if (!index.Load(EventIndex::SidecarPath(key), key) && !reader.BuildIndex(index)) {
+        std::cerr << "No events in " << filename << std::endl;
+        return 1;
+    }
+
+    typedef std::chrono::steady_clock clock;
+    double decodeMs = 0, quantitiesMs = 0;
+    long nEvents = 0, nTracks = 0, nPoints = 0;
+
+    EventData data;
+    for (int evtID : index.GetEventIDs()) {
+        if (maxEvents >= 0 && nEvents >= maxEvents) break;
+
+        // decoding already includes one quantities pass...
+        auto t0 = clock::now();
+        if (!reader.ReadEvent(*index.Find(evtID), data)) return 1;
+        auto t1 = clock::now();
+        // ...time it again on its own
+        ComputeTrackQuantities(data);
+        auto t2 = clock::now();
+
+        decodeMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        quantitiesMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+        nTracks += data.NTracks();
+        nPoints += data.NPoints();
+        ++nEvents;
+    }
+
+    if (nEvents == 0) return 1;
+    std::cout << "events:           " << nEvents << "\n"
+              << "tracks/event:     " << double(nTracks) / nEvents << "\n"
+              << "points/event:     " << double(nPoints) / nEvents << "\n"
+              << "decode ms/event:  " << decodeMs / nEvents << "\n"
+              << "quantities ms/event: " << quantitiesMs / nEvents << "\n"
+              << "quantities/decode: " << 100. * quantitiesMs / decodeMs << " %" << std::endl;
+    return 0;
+}
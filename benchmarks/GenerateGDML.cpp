@@ -0,0 +1,198 @@
+// Writes a synthetic FPF-like GDML: a world with a `hallPV`, and in it
+// the detectors FPFDisplay knows, each a stack of N repeated modules made
+// of absorber/sensitive layers (plus PMTs for FORMOSA), to measure how
+// geometry loading scales with the module count.
+//
+// Usage: GenerateGDML <out.gdml> [--modules N] [--layers N] [--unique]
+//   --modules  modules per detector (default 20, roughly the FPF today)
+//   --layers   absorber/sensitive layer pairs per module (default 10)
+//   --unique   one logical volume per module instead of a shared one,
+//              as if every module had its own dimensions
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    /// One detector: transverse size and layer structure of its modules, in mm
+    struct DetectorSpec {
+        std::string name;      // prefix of the volume names
+        std::string physical;  // name of the placement in the hall
+        double x, y;
+        double absorber, sensitive; // layer thicknesses
+        std::string absorberName, sensitiveName;
+        std::string absorberMat, sensitiveMat;
+        int pmts;              // PMT tubes at the back of each module
+    };
+
+    // names follow the FPFSim volumes matched by config/geometry_style.txt
+    const std::vector<DetectorSpec> kDetectors = {
+        {"FLArE",    "FLArETPCPhysical", 1800, 1800, 10, 60, "Cryostat", "LArTPC", "Iron", "LAr", 0},
+        {"FASERnu2", "FASERnu2Physical", 400, 400, 8, 2, "tungstenPlate", "emulsionFilm", "Tungsten", "Emulsion", 0},
+        {"FORMOSA",  "FORMOSAPhysical", 200, 200, 5, 100, "Wrapping", "Scintillator", "Aluminium", "Plastic", 4},
+        {"FASER2",   "FASER2Physical", 3000, 1000, 50, 20, "IronYoke", "CalLayer", "Iron", "Plastic", 0},
+        {"BabyMIND", "BabyMINDPhysical", 3500, 2000, 30, 10, "MagnetPlate", "ScintillatorModule", "Iron", "Plastic", 0},
+    };
+
+    const double kGap = 20;      // between modules, mm
+    const double kDetGap = 2000; // between detectors, mm
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args;
+    int nModules = 20;
+    int nLayers = 10;
+    bool unique = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--modules" && i+1 < argc) nModules = std::atoi(argv[++i]);
+        else if (arg == "--layers" && i+1 < argc) nLayers = std::atoi(argv[++i]);
+        else if (arg == "--unique") unique = true;
+        else args.push_back(arg);
+    }
+    if (args.size() != 1 || nModules <= 0 || nLayers <= 0) {
+        std::cerr << "Usage: " << argv[0] << " <out.gdml> [--modules N] [--layers N] [--unique]\n";
+        return 1;
+    }
+
+    std::ostringstream solids, structure, hall;
+    int nPlacements = 0;
+    auto box = [&](const std::string& name, double x, double y, double z) {
+        solids << "  <box name=\"" << name << "_s\" x=\"" << x << "\" y=\"" << y << "\" z=\"" << z << "\" lunit=\"mm\"/>\n";
+    };
+    auto volume = [&](const std::string& name, const std::string& material) {
+        structure << "  <volume name=\"" << name << "\">\n"
+                  << "   <materialref ref=\"" << material << "\"/>\n"
+                  << "   <solidref ref=\"" << name << "_s\"/>\n";
+    };
+    auto place = [&](std::ostream& out, const std::string& name, const std::string& logical, double x, double y, double z) {
+        out << "   <physvol name=\"" << name << "\">\n"
+            << "    <volumeref ref=\"" << logical << "\"/>\n"
+            << "    <position name=\"" << name << "_pos\" x=\"" << x << "\" y=\"" << y << "\" z=\"" << z << "\" unit=\"mm\"/>\n"
+            << "   </physvol>\n";
+        ++nPlacements;
+    };
+
+    // detectors one after the other along the beam, centred in the hall at the end
+    struct Placement { std::string name, logical; double z; };
+    std::vector<Placement> detectors;
+    double z = 0, hallX = 0, hallY = 0;
+    long nodes = 2;
+    for (const DetectorSpec& d : kDetectors) {
+        const double mx = d.x - 2 * kGap, my = d.y - 2 * kGap;
+        const double mz = nLayers * (d.absorber + d.sensitive);
+        const double pitch = mz + kGap;
+        const double length = nModules * pitch + kGap;
+
+        // layers, shared by all modules
+        box(d.name + d.absorberName, mx, my, d.absorber);
+        volume(d.name + d.absorberName, d.absorberMat);
+        structure << "  </volume>\n";
+        box(d.name + d.sensitiveName, mx, my, d.sensitive);
+        volume(d.name + d.sensitiveName, d.sensitiveMat);
+        structure << "  </volume>\n";
+        if (d.pmts > 0) {
+            solids << "  <tube name=\"" << d.name << "PMT_s\" rmin=\"0\" rmax=\"" << mx / (2 * d.pmts + 1)
+                   << "\" z=\"" << kGap / 2 << "\" deltaphi=\"360\" aunit=\"deg\" lunit=\"mm\"/>\n";
+            volume(d.name + "PMT", "Glass");
+            structure << "  </volume>\n";
+        }
+
+        // modules: one logical volume placed N times, or N different ones
+        const int nLogical = unique ? nModules : 1;
+        if (!unique) box(d.name + "Module", mx, my, mz + kGap / 2);
+        for (int m = 0; m < nLogical; ++m) {
+            const std::string module = d.name + "Module" + (unique ? std::to_string(m) : "");
+            if (unique) box(module, mx, my, mz + kGap / 2);
+            volume(module, "Air");
+            double lz = -(mz + kGap / 2) / 2;
+            for (int l = 0; l < nLayers; ++l) {
+                place(structure, module + "_" + d.absorberName + std::to_string(l), d.name + d.absorberName, 0, 0, lz + d.absorber / 2);
+                lz += d.absorber;
+                place(structure, module + "_" + d.sensitiveName + std::to_string(l), d.name + d.sensitiveName, 0, 0, lz + d.sensitive / 2);
+                lz += d.sensitive;
+            }
+            for (int p = 0; p < d.pmts; ++p) {
+                const double px = -mx / 2 + (2 * p + 1.5) * mx / (2 * d.pmts + 1);
+                place(structure, module + "_PMT" + std::to_string(p), d.name + "PMT", px, 0, lz + kGap / 4);
+            }
+            structure << "  </volume>\n";
+        }
+
+        // detector envelope
+        box(d.name, d.x, d.y, length);
+        volume(d.name, "Air");
+        for (int m = 0; m < nModules; ++m) {
+            const std::string module = d.name + "Module" + (unique ? std::to_string(m) : "");
+            place(structure, d.name + "Module_PV" + std::to_string(m), module, 0, 0, -length / 2 + kGap + m * pitch + (mz + kGap / 2) / 2);
+        }
+        structure << "  </volume>\n";
+
+        detectors.push_back({d.physical, d.name, z + length / 2});
+        z += length + kDetGap;
+        nodes += 1 + nModules * (1 + 2 * nLayers + d.pmts);
+        hallX = std::max(hallX, d.x);
+        hallY = std::max(hallY, d.y);
+    }
+
+    // some hall infrastructure, for the "Other" detector
+    box("Shielding", hallX + 2 * kDetGap, 500, 2 * kDetGap);
+    volume("Shielding", "Concrete");
+    structure << "  </volume>\n";
+    const double total = z - kDetGap;
+    for (const Placement& p : detectors)
+        place(hall, p.name, p.logical, 0, 0, p.z - total / 2);
+    place(hall, "ShieldingPhysical", "Shielding", 0, -hallY / 2 - kDetGap, -total / 2 - kDetGap);
+    ++nodes;
+
+    // the hall around the detectors, the world around it
+    const double hallZ = total + 4 * kDetGap;
+    const double hallW = hallX + 6 * kDetGap, hallH = hallY + 6 * kDetGap;
+    box("Hall", hallW, hallH, hallZ);
+    box("World", hallW + 1000, hallH + 1000, hallZ + 1000);
+
+    std::ofstream out(args[0]);
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<gdml xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
+        << "xsi:noNamespaceSchemaLocation=\"http://service-spi.web.cern.ch/service-spi/app/releases/GDML/schema/gdml.xsd\">\n"
+        << " <define/>\n"
+        << " <materials>\n";
+    const char* materials[][4] = {
+        // name, Z, density g/cm3, atomic mass g/mole
+        {"Air", "7", "0.0012", "14.0"},     {"Iron", "26", "7.87", "55.85"},
+        {"LAr", "18", "1.39", "39.95"},     {"Tungsten", "74", "19.3", "183.84"},
+        {"Emulsion", "35", "3.4", "79.9"},  {"Aluminium", "13", "2.7", "26.98"},
+        {"Plastic", "6", "1.03", "12.01"},  {"Glass", "14", "2.23", "28.09"},
+        {"Concrete", "14", "2.3", "28.09"},
+    };
+    for (const auto& m : materials)
+        out << "  <material name=\"" << m[0] << "\" Z=\"" << m[1] << "\"><D value=\"" << m[2]
+            << "\" unit=\"g/cm3\"/><atom value=\"" << m[3] << "\" unit=\"g/mole\"/></material>\n";
+    out << " </materials>\n"
+        << " <solids>\n" << solids.str() << " </solids>\n"
+        << " <structure>\n" << structure.str()
+        << "  <volume name=\"Hall\">\n   <materialref ref=\"Air\"/>\n   <solidref ref=\"Hall_s\"/>\n"
+        << hall.str() << "  </volume>\n"
+        << "  <volume name=\"World\">\n   <materialref ref=\"Air\"/>\n   <solidref ref=\"World_s\"/>\n";
+    place(out, "hallPV", "Hall", 0, 0, 0);
+    out << "  </volume>\n"
+        << " </structure>\n"
+        << " <setup name=\"Default\" version=\"1.0\">\n  <world ref=\"World\"/>\n </setup>\n"
+        << "</gdml>\n";
+
+    if (!out) {
+        std::cerr << "Cannot write " << args[0] << std::endl;
+        return 1;
+    }
+
+    // every placement of a shared module repeats its layers in the full tree
+    std::cout << "Wrote " << args[0] << ": " << kDetectors.size() << " detectors of " << nModules << " modules with "
+              << nLayers << " layer pairs, " << nPlacements << " placements, " << nodes << " physical nodes"
+              << (unique ? ", no shared modules" : "") << std::endl;
+    return 0;
+}
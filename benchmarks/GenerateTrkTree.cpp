@@ -0,0 +1,130 @@
+// Writes a synthetic FPFSim output file: a `trk` tree with one entry
+// per track and the branches read by FPFDisplay, so the benchmarks can
+// run without production files.
+//
+// Usage: GenerateTrkTree <out.root> [--events N] [--tracks N] [--points N] [--seed S]
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+#include "TMath.h"
+#include "TRandom3.h"
+#include "TTree.h"
+
+namespace {
+    // a plausible mix of FPFSim particles: leptons, photons, hadrons
+    const int kPDGs[] = {13, -13, 11, -11, 22, 22, 22, 211, -211, 111, 2212, 2112, 321};
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args;
+    int nEvents = 1000;
+    int nTracks = 200;
+    int nPoints = 100;
+    unsigned seed = 12345;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--events" && i+1 < argc) nEvents = std::atoi(argv[++i]);
+        else if (arg == "--tracks" && i+1 < argc) nTracks = std::atoi(argv[++i]);
+        else if (arg == "--points" && i+1 < argc) nPoints = std::atoi(argv[++i]);
+        else if (arg == "--seed" && i+1 < argc) seed = std::strtoul(argv[++i], nullptr, 10);
+        else args.push_back(arg);
+    }
+    if (args.size() != 1 || nEvents <= 0 || nTracks <= 0 || nPoints < 2) {
+        std::cerr << "Usage: " << argv[0] << " <out.root> [--events N] [--tracks N] [--points N] [--seed S]\n";
+        return 1;
+    }
+
+    TFile* file = TFile::Open(args[0].c_str(), "RECREATE");
+    if (!file || file->IsZombie()) {
+        std::cerr << "Cannot create " << args[0] << std::endl;
+        return 1;
+    }
+
+    // same branch names and types as the FPFSim analysis manager
+    int evtID, trackTID, trackPID, trackPDG, trackNPoints;
+    double trackKinE;
+    std::vector<double> trackPointX, trackPointY, trackPointZ;
+    TTree* tree = new TTree("trk", "trajectories");
+    tree->Branch("evtID", &evtID);
+    tree->Branch("trackTID", &trackTID);
+    tree->Branch("trackPID", &trackPID);
+    tree->Branch("trackPDG", &trackPDG);
+    tree->Branch("trackKinE", &trackKinE);
+    tree->Branch("trackNPoints", &trackNPoints);
+    tree->Branch("trackPointX", &trackPointX);
+    tree->Branch("trackPointY", &trackPointY);
+    tree->Branch("trackPointZ", &trackPointZ);
+
+    TRandom3 rng(seed);
+    const int nPDGs = sizeof(kPDGs) / sizeof(kPDGs[0]);
+    std::vector<double> start(3);
+
+    for (evtID = 0; evtID < nEvents; ++evtID) {
+        // interaction vertex somewhere in the hall, in mm
+        const double vx = rng.Uniform(-500, 500);
+        const double vy = rng.Uniform(-500, 500);
+        const double vz = rng.Uniform(0, 7000);
+        const int nPrimaries = std::max(1, nTracks / 20);
+
+        // points of the tracks written so far, secondaries start on them
+        std::vector<double> ex, ey, ez;
+
+        for (int t = 0; t < nTracks; ++t) {
+            trackTID = t + 1;
+            const bool primary = t < nPrimaries;
+            if (primary) {
+                trackPID = 0;
+                trackKinE = rng.Uniform(1e3, 1e5);
+                start = {vx, vy, vz};
+            } else {
+                // a secondary of any earlier track, starting from one of its points
+                trackPID = 1 + rng.Integer(t);
+                trackKinE = rng.Exp(100);
+                const std::size_t p = (trackPID - 1) * nPoints + rng.Integer(nPoints);
+                start = {ex[p], ey[p], ez[p]};
+            }
+            trackPDG = kPDGs[rng.Integer(nPDGs)];
+            trackNPoints = nPoints;
+
+            // forward-going primaries, isotropic secondaries, both slowly curling
+            double theta = primary ? rng.Uniform(0, 0.3) : std::acos(rng.Uniform(-1, 1));
+            double phi = rng.Uniform(0, TMath::TwoPi());
+            const double step = primary ? 20. : 1. + std::min(trackKinE, 1000.) / 50.;
+            const double bend = rng.Gaus(0, primary ? 0.002 : 0.05);
+
+            trackPointX.resize(nPoints);
+            trackPointY.resize(nPoints);
+            trackPointZ.resize(nPoints);
+            double x = start[0], y = start[1], z = start[2];
+            for (int k = 0; k < nPoints; ++k) {
+                trackPointX[k] = x;
+                trackPointY[k] = y;
+                trackPointZ[k] = z;
+                x += step * std::sin(theta) * std::cos(phi);
+                y += step * std::sin(theta) * std::sin(phi);
+                z += step * std::cos(theta);
+                phi += bend;
+                theta += rng.Gaus(0, 0.01);
+            }
+            ex.insert(ex.end(), trackPointX.begin(), trackPointX.end());
+            ey.insert(ey.end(), trackPointY.begin(), trackPointY.end());
+            ez.insert(ez.end(), trackPointZ.begin(), trackPointZ.end());
+
+            tree->Fill();
+        }
+    }
+
+    file->Write();
+    std::cout << "Wrote " << nEvents << " events of " << nTracks << " tracks with " << nPoints
+              << " points (" << tree->GetEntries() << " entries, "
+              << file->GetSize() / (1 << 20) << " MB) to " << args[0] << std::endl;
+    file->Close();
+    delete file;
+    return 0;
+}
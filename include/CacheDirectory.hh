@@ -0,0 +1,65 @@
+#ifndef CACHEDIRECTORY_H
+#define CACHEDIRECTORY_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "EventIndex.hh"
+
+/**
+ * Directory for FPFDisplay cache files (event indices, ...):
+ * $FPFDISPLAY_CACHE_DIR if set, else $XDG_CACHE_HOME/fpfdisplay,
+ * else ~/.cache/fpfdisplay. Created on first use.
+ * Returns an empty string if no writable directory could be made.
+ */
+std::string GetCacheDirectory();
+
+/**
+ * Cache file of a data file: <cache directory>/<MD5 of its absolute path><extension>.
+ * Empty if there is no cache directory.
+ */
+std::string GetCacheFile(const std::string& dataFile, const std::string& extension);
+
+/**
+ * Format of a sidecar file: an 8 byte magic, the version and the record
+ * size, then the key of the data file it was built from, the number of
+ * records and the records. Native byte order.
+ */
+struct SidecarFormat {
+    const char* magic;   // 8 bytes
+    uint32_t version;    // bump whenever the record or the layout changes
+    uint32_t recordSize;
+};
+
+/**
+ * Open a sidecar file and check its header against `format` and `key`.
+ * On success `in` is left at the records and `n` is their number,
+ * checked against the size of the file.
+ */
+bool OpenSidecar(const std::string& path, const SidecarFormat& format, const EventIndex::Key& key,
+                 std::ifstream& in, uint64_t& n);
+
+/// Read the records of a sidecar file, false if missing, empty, of another format or built for another key
+template <typename T>
+bool ReadSidecar(const std::string& path, const SidecarFormat& format, const EventIndex::Key& key, std::vector<T>& records)
+{
+    std::ifstream in;
+    uint64_t n = 0;
+    if (!OpenSidecar(path, format, key, in, n) || n == 0) return false;
+    std::vector<T> read(n);
+    in.read(reinterpret_cast<char*>(read.data()), n * sizeof(T));
+    if (!in) return false;
+    records.swap(read);
+    return true;
+}
+
+/**
+ * Write a sidecar file. It is written to a temporary file renamed at the
+ * end, so that a concurrent reader never sees a partially written file.
+ */
+bool WriteSidecar(const std::string& path, const SidecarFormat& format, const EventIndex::Key& key,
+                  const void* records, uint64_t n);
+
+#endif // CACHEDIRECTORY_H
@@ -0,0 +1,121 @@
+#ifndef COMPACTEVENTFILE_H
+#define COMPACTEVENTFILE_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "EventData.hh"
+
+/**
+ * Display-only copy of an FPFSim `trk` tree, written by FPFConvert:
+ * per event the track columns as plain arrays, with the quantities of
+ * TrackQuantities; then the points of each track quantized to a fixed
+ * step (10 um by default) and delta encoded as zigzag varints, x y z
+ * interleaved; then the RDP significances of the inner points, at the
+ * same step. A table at the end gives the offset of each event, sorted
+ * by evtID.
+ *
+ * The file is memory-mapped. Reading an event copies its track columns
+ * out of the mapping and decodes its points and significances into an
+ * EventData: no read call, staging buffer nor decompression, and nothing
+ * left to compute. Native byte order, like the sidecars.
+ */
+class CompactEventFile {
+public:
+    /// One event of the table
+    struct Event {
+        int32_t evtID;
+        uint32_t nTracks;
+        uint64_t nPoints;
+        uint64_t offset; // of its block, from the start of the file
+        uint64_t bytes;  // size of its block
+    };
+
+    CompactEventFile() = default;
+    ~CompactEventFile();
+    CompactEventFile(const CompactEventFile&) = delete;
+    CompactEventFile& operator=(const CompactEventFile&) = delete;
+
+    /// Whether a file starts with the compact format magic
+    static bool IsCompact(const std::string& filename);
+
+    /// Map a file and check its header and table
+    bool Open(const std::string& filename);
+    void Close();
+    bool IsOpen() const { return base_ != nullptr; }
+
+    std::size_t NEvents() const { return nEvents_; }
+    const Event& GetEvent(std::size_t i) const { return table_[i]; }
+    /// Quantization step of the points, cm
+    double GetQuantum() const { return quantum_; }
+    std::size_t GetSize() const { return size_; }
+
+    /// Track columns of an event, pointing into the mapping
+    struct Tracks {
+        const int32_t* tid;
+        const int32_t* pid;
+        const int32_t* pdg;
+        const float* kinE;
+        const uint32_t* nPoints;
+        const float* length;
+        const float* displacement;
+        const float *xmin, *xmax, *ymin, *ymax, *zmin, *zmax;
+    };
+    Tracks GetTracks(std::size_t i) const;
+
+    /// First point of each track of an event, in cm; the other points are skipped, not converted
+    bool GetFirstPoints(std::size_t i, std::vector<float>& x, std::vector<float>& y, std::vector<float>& z) const;
+
+    /// Decode event i: track columns and quantities, points and significances.
+    /// Gives up, returning false, as soon as `cancel` is set. Over `maxPoints`
+    /// (0 = no cap) only the tracks picked by SelectTracks are stored.
+    bool ReadEvent(std::size_t i, EventData& data, const std::atomic<bool>* cancel = nullptr, int64_t maxPoints = 0) const;
+
+private:
+    const char* base_ = nullptr;
+    std::size_t size_ = 0;
+    const Event* table_ = nullptr;
+    std::size_t nEvents_ = 0;
+    double quantum_ = 0;
+
+    /// Whether the table entry of event i points inside the file
+    bool CheckEvent(std::size_t i) const;
+};
+
+/**
+ * Writes a CompactEventFile event by event; the table is sorted by
+ * evtID when closing. evtIDs must be unique. The file is written under
+ * a temporary name and renamed by Close(), a writer destroyed before
+ * removes it.
+ */
+class CompactEventWriter {
+public:
+    ~CompactEventWriter();
+
+    /// Create the file, `quantum` in cm
+    bool Open(const std::string& filename, double quantum = 1e-3);
+    /// Append an event, with its track quantities and significances as filled
+    /// by EventReader; returns the largest quantization error of its points,
+    /// in cm, negative on errors
+    double AddEvent(const EventData& data);
+    /// Write the table and the header and rename the file, false on errors
+    bool Close();
+    /// Give up the file being written
+    void Discard();
+
+    uint64_t GetBytes() const { return offset_; }
+
+private:
+    std::ofstream out_;
+    std::string filename_;
+    std::string tmpFilename_;
+    double quantum_ = 1e-3;
+    uint64_t offset_ = 0;
+    std::vector<CompactEventFile::Event> table_;
+    std::vector<unsigned char> block_; // event being encoded
+};
+
+#endif // COMPACTEVENTFILE_H
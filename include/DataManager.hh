@@ -1,43 +1,199 @@
 #ifndef DATAMANAGER_H
 #define DATAMANAGER_H
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
-#include "TFile.h"
-#include "TTreeReader.h"
 #include "TEveElement.h"
-#include "TEveLine.h"
+#include "EventCache.hh"
+#include "EventChain.hh"
+#include "EventData.hh"
+#include "EventSummary.hh"
+#include "TrackBatch.hh"
 
 class DataManager {
 public:
     DataManager();
     ~DataManager();
 
+    /// Load ROOT files, chained in order; wildcards are expanded.
+    /// Files are only opened when navigation reaches them or to
+    /// index them when they have no sidecar index.
+    bool LoadFiles(const std::vector<std::string>& patterns);
     /// Load a ROOT file.
-    bool LoadFile(const std::string& filename);
+    bool LoadFile(const std::string& filename) { return LoadFiles({filename}); }
 
-    /// Move to next event.
+    /// Maximum number of data files open at once by the GUI thread.
+    void SetMaxOpenFiles(int n) { chain_.SetMaxOpenFiles(n); }
+    std::size_t GetNFiles() const { return chain_.NFiles(); }
+    const std::string& GetFileName(int file) const { return chain_.GetFileName(file); }
+
+    /// Event IDs of a ROOT file, without loading it nor starting any thread.
+    /// Also saves the event index to the cache directory for later loads.
+    static std::vector<int> ReadEventList(const std::string& filename);
+
+    /// Move to next event, indexing the next file at the end of one.
     bool NextEvent();
     /// Move to the previous event.
     bool PrevEvent();
-    /// Load selected event.
+    /// Move to the event with the given ID, navigating all events
+    /// again if the current query does not select it.
+    /// The current file is searched first, then the other files already
+    /// indexed, in order; the files not indexed yet are not opened.
+    bool GoToEvent(int evtID);
+    /// Look for an event in the files not indexed yet, indexing them in order
+    /// in a background thread. False if there is no such file.
+    bool SearchAllFiles(int evtID);
+    /// Take the indexes built by the search so far; true once the event is
+    /// found and selected. Called from the GUI thread until IsSearching() is false.
+    bool PollSearch();
+    /// Whether a SearchAllFiles() is still running.
+    bool IsSearching() const { return searching_; }
+    /// Stop the search, keeping the indexes already built.
+    void StopSearch();
+    /// Move to an event of a given file.
+    bool GoToEvent(const EventRef& ref);
+
+    /// Navigate only the events selected, in the order given, by an EventQuery
+    /// over the per-event summary of all files, computed on first use. "" selects all events.
+    /// On errors the selection is kept and `error` tells why.
+    bool SetQuery(const std::string& query, std::string& error);
+    const std::string& GetQuery() const { return query_; }
+    /// Events navigated with Prev/Next, in order.
+    const std::vector<EventRef>& GetSelection() const { return eventList_; }
+    /// Load selected event. In progressive mode only the primaries and
+    /// the first chunk of secondaries are built, see BuildNextChunk().
     bool LoadEvent();
+    /// Load the selected event without blocking: decoded by the cache worker,
+    /// then built by PollEvent(). Supersedes a request still pending.
+    /// Falls back to LoadEvent() when the cache is disabled.
+    bool RequestEvent();
+    /// Build the requested event if it has arrived, true if it was built.
+    /// Called from the GUI thread until IsLoading() is false.
+    bool PollEvent();
+    /// Whether a RequestEvent() is still pending.
+    bool IsLoading() const { return loading_; }
+
+    /// Add the next chunk of tracks of the current event to the display,
+    /// false if there was none left.
+    bool BuildNextChunk();
+    /// Whether all the tracks of the current event kept by the vertex cap are built.
+    bool IsEventComplete() const { return nextPending_ >= pending_.size(); }
+
+    /// ID of the selected event.
+    int GetCurrentEvent() const { return current_.evtID; }
+    /// File and ID of the selected event.
+    const EventRef& GetCurrent() const { return current_; }
+    /// Number of events known: all of them once summarized for a query,
+    /// otherwise those of the files navigated so far.
+    std::size_t GetNEvents() const { return summaryRows_.empty() ? fileEvents_.size() : summaryRows_.size(); }
+    /// Whether all files are indexed and their events navigable.
+    bool AllFilesListed() const { return nListed_ == (int) chain_.NFiles(); }
+
+    /// Change the selection cuts and re-filter the current event in memory.
+    /// Returns true if any track was shown or hidden. If the vertex cap
+    /// left tracks out, the event is built again for the new cuts.
+    bool SetCuts(double kinECut, double lengthCut);
+    double GetKinECut() const { return kinECut_; }
+    double GetLengthCut() const { return lengthCut_; }
+
+    /// Memory limit of the decoded event cache (0 disables it).
+    void SetCacheSize(std::size_t megabytes) { cache_.SetCapacity(megabytes); }
+    /// Number of events prefetched on each side of the current one.
+    void SetPrefetchDepth(int depth) { prefetchDepth_ = depth; }
+
+    /// Build events in chunks of about `vertices` trajectory points,
+    /// primaries first then secondaries by decreasing energy (0 = all at once).
+    void SetChunkVertices(Long64_t vertices) { chunkVertices_ = vertices; }
+    /// Hard cap on the trajectory points of the tracks decoded and built for
+    /// an event (0 = no cap); the least energetic secondaries are left out.
+    /// Set before LoadFiles, events decoded already keep their tracks.
+    void SetMaxVertices(Long64_t vertices);
+    /// Tracks of the current event left out by the vertex cap.
+    Long64_t GetNOmittedTracks() const { return nOmittedTracks_; }
 
     /// Text summary of the current event.
     std::string GetSummary() const;
 
 private:
-    int currentEvent_;
+    EventRef current_;
     int currentIndex_;
+    int prefetchDepth_ = 2;
     double kinECut_ = 60; //MeV
     double lengthCut_ = 15; //cm
-    TFile* rootFile_;
 
-    std::vector<int> eventList_;
+    std::vector<EventRef> eventList_;  // navigable events
+    std::vector<EventRef> fileEvents_; // events of the files [0, nListed_), sorted
+    int nListed_ = 0;
+    std::string query_;
+    std::vector<EventSummary::Row> summaryRows_; // of all files
+    std::vector<int> summaryFiles_;              // file of each row
+    EventChain chain_;
+    EventCache cache_;
+    std::shared_ptr<const EventData> currentData_;
+    bool loading_ = false;
+    std::chrono::steady_clock::time_point loadStart_;
     TEveElementList* trackList_;
-    TTreeReader trajReader_;
+    TrackBatch* trackBatch_;
+
+    Long64_t chunkVertices_ = 100000;
+    Long64_t maxVertices_ = 5000000;
+    std::vector<uint32_t> pending_; // tracks of the current event to build, in order
+    std::size_t nextPending_ = 0;
+    Long64_t nOmittedTracks_ = 0;
+    Long64_t nOmittedVertices_ = 0;
+
+    // SearchAllFiles: indexes built in searcher_, given to chain_ by PollSearch
+    std::thread searcher_;
+    std::mutex searchMutex_;
+    std::vector<std::pair<int, EventIndex>> searchIndexed_; // file, index
+    std::atomic<bool> searchStop_{false};
+    std::atomic<bool> searchDone_{false};
+    bool searching_ = false;
+    int searchID_ = -1;
+
+    /// Files neither indexed nor failed
+    int CountUnindexed() const;
+
+    /// Entry range of the selected event, nullptr (with a message) if there is none
+    const EventIndex::Entry* FindCurrent();
+    /// Display decoded event data as the current event
+    void BuildEvent(const std::shared_ptr<const EventData>& data);
+
+    /// Order the tracks of the current event and apply the vertex cap,
+    /// then fill the batch with the first chunk
+    void StartBuild();
+    /// Next tracks of pending_, about chunkVertices_ points
+    std::vector<uint32_t> NextChunk();
+
+    /// Whether a track passes the kinetic energy and length cuts
+    bool PassesCuts(std::size_t i) const;
+
+    bool HasData() const { return !fileEvents_.empty(); }
+
+    /// Append the events of the next file that can be indexed, false at the end
+    bool ListNextFile();
+
+    /// Load the sidecar event summaries of all files, or build and save them
+    bool LoadSummaries();
+
+    /// Show/hide the tracks of the current event according to the cuts,
+    /// returns the number of tracks that changed
+    int ApplyCuts();
+
+    /// Vertex count of the displayed tracks at each level of detail
+    std::string GetLODSummary() const;
+
+    /// Bytes, read calls and decompression time spent on the current event
+    std::string GetIOSummary() const;
 
-    void SetTrackStylebyPDG(TEveLine *track, int pdg);
+    /// Queue the neighbours of the current event for prefetching
+    void RequestPrefetch();
 };
 
 #endif // DATAMANAGER_H
@@ -0,0 +1,108 @@
+#ifndef EVENTCACHE_H
+#define EVENTCACHE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "EventChain.hh"
+#include "EventData.hh"
+
+/**
+ * Bounded LRU cache of decoded events, filled by a background
+ * worker that prefetches the events around the current one
+ * through its own EventChain, with at most two files open.
+ * The worker also loads the event to display (Load/TakeLoaded),
+ * so that the GUI thread never waits for a decode.
+ */
+class EventCache {
+public:
+    EventCache();
+    ~EventCache();
+
+    /// Maximum memory held by cached events
+    void SetCapacity(std::size_t megabytes);
+    /// Decode at most this many points per event (0 = all), from the next Start
+    void SetMaxPoints(Long64_t points) { maxPoints_ = points; }
+
+    /// Start the prefetch worker on the given files (an expanded EventChain)
+    void Start(const std::vector<std::string>& filenames);
+    /// Stop the worker, pending requests are dropped
+    void Stop();
+    /// Drop all cached events and reset the counters
+    void Clear();
+
+    /// Cached event, nullptr on a miss. Waits if the worker is decoding it.
+    std::shared_ptr<const EventData> Get(const EventRef& ref);
+    /// Add an event decoded elsewhere
+    void Put(const std::shared_ptr<const EventData>& data);
+
+    /// An event to prefetch and its entry range
+    struct Request {
+        int file;
+        EventIndex::Entry range;
+    };
+    /// Replace the pending prefetch requests, in priority order
+    void Prefetch(const std::vector<Request>& events);
+
+    /// Decode an event ahead of all prefetching, to be picked up with TakeLoaded.
+    /// Supersedes the previous Load: its decode is cancelled if in flight.
+    void Load(const Request& event);
+    /// True once the event of the last Load is done, with the event or
+    /// nullptr if it could not be read; false while it is loading.
+    bool TakeLoaded(const EventRef& ref, std::shared_ptr<const EventData>& data);
+    /// Whether the worker runs (not if the cache is disabled)
+    bool IsRunning() const { return worker_.joinable(); }
+
+    unsigned long GetHits() const { return hits_; }
+    unsigned long GetMisses() const { return misses_; }
+    unsigned long GetCancelled() const { return cancelled_; }
+    std::size_t GetBytes() const;
+    std::size_t GetCapacity() const { return capacity_; }
+
+private:
+    typedef Long64_t SlotKey; // file << 32 | evtID
+    static SlotKey MakeSlotKey(int file, int evtID) { return (SlotKey(file) << 32) | uint32_t(evtID); }
+
+    struct Slot {
+        std::shared_ptr<const EventData> data;
+        std::list<SlotKey>::iterator pos;
+    };
+
+    std::size_t capacity_;
+    Long64_t maxPoints_;
+    std::size_t bytes_;
+    std::atomic<unsigned long> hits_; // counters, read without the lock
+    std::atomic<unsigned long> misses_;
+    std::atomic<unsigned long> cancelled_;
+
+    std::list<SlotKey> lru_; // most recently used first
+    std::unordered_map<SlotKey, Slot> slots_;
+    std::deque<Request> queue_;
+    SlotKey inFlight_;
+    bool stop_;
+
+    SlotKey wanted_;   // event of the last Load, until taken
+    Request wantedRequest_;
+    bool wantedDone_;
+    std::shared_ptr<const EventData> loaded_;
+    std::atomic<bool> cancel_; // abort the decode in flight
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::thread worker_;
+
+    void Run(std::vector<std::string> filenames);
+    /// Insert and evict down to capacity, mutex_ must be held
+    void Insert(const std::shared_ptr<const EventData>& data);
+};
+
+#endif // EVENTCACHE_H
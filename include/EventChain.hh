@@ -0,0 +1,98 @@
+#ifndef EVENTCHAIN_H
+#define EVENTCHAIN_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "EventData.hh"
+#include "EventIndex.hh"
+#include "EventReader.hh"
+
+/// An event of a chain: file number and evtID within that file
+struct EventRef {
+    int file;
+    int evtID;
+    bool operator==(const EventRef& o) const { return file == o.file && evtID == o.evtID; }
+    bool operator!=(const EventRef& o) const { return !(*this == o); }
+    bool operator<(const EventRef& o) const { return file != o.file ? file < o.file : evtID < o.evtID; }
+};
+
+/**
+ * The FPFSim files of a production, chained over their `trk` tree.
+ * Nothing is opened up front: the index of a file is read from its
+ * sidecar if there is one, and the file is only opened to build a
+ * missing index or to read events. At most GetMaxOpenFiles() files are
+ * open at a time, the least recently used one is closed first.
+ */
+class EventChain {
+public:
+    /// Expand shell wildcards (*, ?, [...]), each pattern sorted, in order.
+    /// Patterns matching nothing are kept as they are.
+    static std::vector<std::string> Expand(const std::vector<std::string>& patterns);
+
+    /// Use the files matched by the patterns, see Expand. Closes all files.
+    void SetFiles(const std::vector<std::string>& patterns);
+    std::size_t NFiles() const { return files_.size(); }
+    const std::string& GetFileName(int file) const { return files_[file].name; }
+    std::vector<std::string> GetFileNames() const;
+
+    /// Maximum number of files open at once (at least 1)
+    void SetMaxOpenFiles(int n);
+    int GetMaxOpenFiles() const { return maxOpen_; }
+    int GetNOpenFiles() const { return nOpen_; }
+
+    /// Decode at most this many points per event (0 = all), see EventReader::SetMaxPoints
+    void SetMaxPoints(Long64_t points);
+
+    /// Read the sidecar indexes that exist, without opening any file.
+    /// Returns the number of files indexed.
+    int LoadSidecars();
+
+    /// Index of a file, opened and indexed if needed (the index is then saved).
+    /// nullptr if the file cannot be read.
+    const EventIndex* GetIndex(int file);
+    bool IsIndexed(int file) const { return files_[file].indexed; }
+    /// Whether a file could not be opened or indexed (not retried)
+    bool IsFailed(int file) const { return files_[file].failed; }
+    /// Use an index built elsewhere, e.g. by another thread, unless the file has one
+    void SetIndex(int file, EventIndex&& index);
+
+    /// Read the sidecar index of a data file, false if there is none for it
+    static bool LoadIndex(const std::string& name, EventIndex& index);
+    /// Build the index of a data file open in `reader` and save it as its sidecar.
+    /// Neither uses a chain: they can run in another thread.
+    static bool BuildIndex(const std::string& name, EventReader& reader, EventIndex& index);
+
+    /// Entry range of an event, nullptr if not found
+    const EventIndex::Entry* Find(const EventRef& ref);
+
+    /// Reader of a file, opened if needed, nullptr on errors
+    EventReader* GetReader(int file);
+
+    /// Read and decode one event
+    bool ReadEvent(const EventRef& ref, EventData& data);
+
+    /// Close all files
+    void Close();
+
+private:
+    struct File {
+        std::string name;
+        EventIndex index;
+        bool indexed = false;
+        bool failed = false; // could not be opened or indexed, not retried
+        std::unique_ptr<EventReader> reader;
+        unsigned long lastUse = 0;
+    };
+    std::vector<File> files_;
+    int maxOpen_ = 16;
+    Long64_t maxPoints_ = 0;
+    int nOpen_ = 0;
+    unsigned long useCounter_ = 0;
+
+    /// Close the least recently used files above the limit, except `keep`
+    void CloseUnused(int keep);
+};
+
+#endif // EVENTCHAIN_H
@@ -0,0 +1,70 @@
+#ifndef EVENTDATA_H
+#define EVENTDATA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Decoded tracks of one event in columnar form, independent of
+ * TEve (and ROOT), so it can be cached, filtered and built off the
+ * GUI thread without per-track allocations.
+ *
+ * Points of all tracks are stored back to back in cm;
+ * track i spans points [offsets[i], offsets[i+1]).
+ */
+struct EventData {
+    int evtID = -1;
+    int file = 0; // in the EventChain
+
+    // I/O spent decoding it, see EventReader
+    int64_t bytesRead = 0;
+    int readCalls = 0;
+    double unzipMs = -1; // < 0 if not measured
+
+    // tracks left out when reading under a point cap, see SelectTracks
+    int64_t nCappedTracks = 0;
+    int64_t nCappedPoints = 0;
+
+    // points
+    std::vector<float> x, y, z;
+    std::vector<uint32_t> offsets{0};
+    std::vector<float> significance; // RDP significance of each point, see TrackSimplify
+
+    // per-track columns
+    std::vector<int> tid;
+    std::vector<int> pid;
+    std::vector<int> pdg;
+    std::vector<float> kinE; // MeV
+
+    // per-track quantities derived from the points, see TrackQuantities
+    std::vector<float> length;       // polyline length, cm
+    std::vector<float> displacement; // distance between first and last point, cm
+    std::vector<float> xmin, xmax, ymin, ymax, zmin, zmax; // bounding box, cm
+
+    std::size_t NTracks() const { return tid.size(); }
+    std::size_t NPoints() const { return x.size(); }
+    uint32_t Begin(std::size_t i) const { return offsets[i]; }
+    uint32_t End(std::size_t i) const { return offsets[i+1]; }
+    uint32_t Size(std::size_t i) const { return offsets[i+1] - offsets[i]; }
+
+    void Clear();
+    void Reserve(std::size_t nTracks, std::size_t nPoints);
+
+    /// Append the columns of a track with n points, whose coordinates
+    /// are filled afterwards by SetPointsFromMM
+    void AddTrack(int trackTID, int trackPID, int trackPDG, float trackKinE, uint32_t n);
+
+    /// Convert the points of all tracks, given in mm, to cm in one bulk pass
+    void SetPointsFromMM(const double* xmm, const double* ymm, const double* zmm);
+
+    /// Approximate memory footprint, used to bound the event cache
+    std::size_t Bytes() const;
+};
+
+/// Tracks to decode when an event may hold at most `maxPoints` points
+/// (0 = no cap), as a mask over its n tracks in entry order: primaries
+/// first, then the others by decreasing kinetic energy, as long as they fit.
+std::vector<char> SelectTracks(std::size_t n, const int* pid, const float* kinE, const uint32_t* nPoints, int64_t maxPoints);
+
+#endif // EVENTDATA_H
@@ -0,0 +1,73 @@
+#ifndef EVENTINDEX_H
+#define EVENTINDEX_H
+
+#include <string>
+#include <vector>
+#include "Rtypes.h"
+#include "TFile.h"
+#include "TTreeReader.h"
+
+class CompactEventFile;
+
+/**
+ * Maps each evtID of the FPFSim `trk` tree to the range of
+ * tree entries [first, last) holding its tracks.
+ * The index can be saved to / loaded from a sidecar file, named
+ * after the data file path and keyed by its UUID, size and modification time.
+ */
+class EventIndex {
+public:
+    struct Entry {
+        int evtID;
+        int nTracks;      // number of tracks (tree entries) in the event
+        Long64_t first;   // first tree entry of the event
+        Long64_t last;    // one past the last tree entry of the event
+        Long64_t nPoints; // total number of trajectory points
+    };
+
+    /// Identifies the data file the index was built from
+    struct Key {
+        std::string path; // absolute, not stored
+        std::string uuid; // empty if the file was not opened
+        Long64_t size = 0;
+        Long64_t mtime = 0;
+        /// The UUID is only compared when both keys have one
+        bool operator==(const Key& o) const
+        {
+            return size == o.size && mtime == o.mtime && (uuid.empty() || o.uuid.empty() || uuid == o.uuid);
+        }
+    };
+
+    /// Build the key of an open data file (without UUID for a nullptr file).
+    static Key MakeKey(TFile* file, const std::string& filename);
+    /// Build the key of a data file without opening it (no UUID).
+    static Key MakeKey(const std::string& filename);
+
+    /// Sidecar file for a given key inside the cache directory (empty if no cache).
+    static std::string SidecarPath(const Key& key);
+
+    /// Build the index in a single pass over the evtID branch.
+    bool Build(TTreeReader& reader);
+    /// Copy the event table of a compact file: the range of an event is
+    /// [position in the table, position + 1).
+    bool Build(const CompactEventFile& file);
+
+    /// Read a sidecar file, fails if missing or built for a different key.
+    bool Load(const std::string& path, const Key& key);
+    /// Write the index to a sidecar file.
+    bool Save(const std::string& path, const Key& key) const;
+
+    /// Entry range of an event, nullptr if not in the index.
+    const Entry* Find(int evtID) const;
+
+    /// Sorted list of all indexed event IDs.
+    std::vector<int> GetEventIDs() const;
+
+    std::size_t Size() const { return entries_.size(); }
+    void Clear() { entries_.clear(); }
+
+private:
+    std::vector<Entry> entries_; // sorted by evtID
+};
+
+#endif // EVENTINDEX_H
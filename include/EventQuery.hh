@@ -0,0 +1,49 @@
+#ifndef EVENTQUERY_H
+#define EVENTQUERY_H
+
+#include <string>
+#include <vector>
+
+#include "EventSummary.hh"
+
+/**
+ * Selects and orders events from their EventSummary with a small
+ * expression language over the summary columns, e.g.
+ *   nMuons > 0 && maxMuonE > 10000 sort maxMuonE desc
+ *   nSecondaries > 500 || (nPhotons >= 2 && abs(vtxX) < 50)
+ * Operators: || && ! == != < <= > >= + - * / ( ), also "and", "or", "not";
+ * functions abs(), sqrt(). Expressions are compiled once to a small
+ * stack program, so that a selection over 100k events takes milliseconds.
+ */
+class EventQuery {
+public:
+    /// Parse "[filter] [sort <expression> [asc|desc]]"; false, with
+    /// a message in `error`, on syntax errors or unknown columns
+    bool Parse(const std::string& text, std::string& error);
+
+    /// Positions in `rows` of the events passing the filter, in sort order (row order without one)
+    std::vector<std::size_t> Select(const std::vector<EventSummary::Row>& rows) const;
+
+    bool HasFilter() const { return !filter_.empty(); }
+    bool HasSort() const { return !sort_.empty(); }
+
+    /// One line per column, for help texts
+    static std::string GetHelp();
+
+    struct Instr {
+        enum Op { kNumber, kColumn, kNeg, kNot, kAbs, kSqrt,
+                  kAdd, kSub, kMul, kDiv, kLt, kLe, kGt, kGe, kEq, kNe, kAnd, kOr } op;
+        double value; // kNumber
+        int column;   // kColumn, index in EventSummary::GetColumns()
+    };
+    typedef std::vector<Instr> Program;
+
+private:
+    Program filter_;
+    Program sort_;
+    bool descending_ = false;
+
+    static double Eval(const Program& program, const EventSummary::Row& row, std::vector<double>& stack);
+};
+
+#endif // EVENTQUERY_H
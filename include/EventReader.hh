@@ -0,0 +1,82 @@
+#ifndef EVENTREADER_H
+#define EVENTREADER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "TFile.h"
+#include "TTreeReader.h"
+#include "EventData.hh"
+#include "EventIndex.hh"
+
+class CompactEventFile;
+class TTreePerfStats;
+
+/// How the `trk` tree is read, the same for all readers of the process
+struct ReadOptions {
+    Long64_t cacheBytes = 32 << 20; // TTreeCache per file, 0 disables it
+    bool prefill = true;            // cache exactly the display branches from the first read,
+                                    // instead of learning them over the first entries
+    int unzipThreads = 0;           // implicit-MT basket decompression, 0 = on the reading thread
+    bool stats = false;             // measure the decompression time (single threaded only)
+};
+
+/**
+ * Owns one handle on an FPFSim output file and decodes the
+ * tracks of an event from the `trk` tree into an EventData.
+ * Files converted by FPFConvert (CompactEventFile) are read
+ * through a memory mapping instead, with the same interface.
+ * Each thread reading the file needs its own EventReader.
+ */
+class EventReader {
+public:
+    EventReader();
+    ~EventReader();
+
+    /// Open a ROOT file and attach to its `trk` tree, or map a compact file.
+    bool Open(const std::string& filename);
+    void Close();
+    bool IsOpen() const { return file_ != nullptr || compact_ != nullptr; }
+
+    /// The ROOT file, nullptr for a compact file
+    TFile* GetFile() const { return file_; }
+    TTreeReader& GetReader() { return reader_; }
+
+    /// Index the events of the file: a pass over evtID, or the table of a compact file,
+    /// where the entry range of an event is its position in the table.
+    bool BuildIndex(EventIndex& index);
+
+    /// Read and decode the entries of one event. Gives up, returning
+    /// false, as soon as `cancel` is set. The bytes read, read calls and
+    /// decompression time are stored in the EventData.
+    bool ReadEvent(const EventIndex::Entry& range, EventData& data, const std::atomic<bool>* cancel = nullptr);
+
+    /// Decode at most this many points per event (0 = all), see SelectTracks;
+    /// the tracks left out are counted in the EventData.
+    void SetMaxPoints(Long64_t points) { maxPoints_ = points; }
+
+    /// Set the read options before opening any file; enables implicit MT if asked.
+    static void SetOptions(const ReadOptions& options);
+    static const ReadOptions& GetOptions();
+
+    /// The branches read for the display, the only ones read at all
+    static const std::vector<std::string>& GetBranches();
+
+private:
+    TFile* file_;
+    TTreeReader reader_;
+    bool treeReady_ = false;             // cache and branches set up, see SetUpTree
+    TTreePerfStats* perfStats_ = nullptr; // with ReadOptions::stats
+    std::unique_ptr<CompactEventFile> compact_;
+    Long64_t maxPoints_ = 0;
+
+    /// Apply the read options to the tree. Done on the first event, after
+    /// the index was built with the evtID branch only.
+    void SetUpTree();
+
+    // staging buffers for the raw points in mm
+    std::vector<double> xmm_, ymm_, zmm_;
+};
+
+#endif // EVENTREADER_H
@@ -0,0 +1,16 @@
+#ifndef EVENTSELECTION_H
+#define EVENTSELECTION_H
+
+#include <string>
+#include <vector>
+
+/// Event IDs of `available` (sorted) selected by `spec`:
+/// "all" or "", or comma-separated IDs and inclusive ranges ("3,10-20"),
+/// or "@file" with one ID or range per line. Unknown IDs are reported and skipped.
+std::vector<int> SelectEvents(const std::string& spec, const std::vector<int>& available);
+
+/// Output file of an event: the first %d (or %0Nd) of `pattern` is replaced
+/// by the event ID, or "_<evtID>" is added before the extension if there is none
+std::string FormatEventFileName(const std::string& pattern, int evtID);
+
+#endif // EVENTSELECTION_H
@@ -0,0 +1,66 @@
+#ifndef EVENTSUMMARY_H
+#define EVENTSUMMARY_H
+
+#include <string>
+#include <vector>
+#include "Rtypes.h"
+
+#include "EventIndex.hh"
+
+/**
+ * Per-event summary columns of an FPFSim file (track counts by
+ * particle type, highest energies, primary vertex), computed in one
+ * multithreaded pass over the `trk` tree (or from the track
+ * columns of a compact file), to select and order events without decoding them.
+ * Saved to / loaded from a sidecar file next to the event index.
+ */
+class EventSummary {
+public:
+    struct Row {
+        int evtID;
+        int nTracks;
+        int nPrimaries;
+        int nMuons;     // |PDG| 13
+        int nElectrons; // |PDG| 11
+        int nPhotons;   // PDG 22
+        int nPions;     // |PDG| 211 and 111
+        int nProtons;   // PDG 2212
+        int nNeutrons;  // PDG 2112
+        Long64_t nPoints;
+        float maxPrimaryE; // MeV, kinetic
+        float maxMuonE;    // MeV, kinetic
+        float vtxX, vtxY, vtxZ; // cm, first point of the most energetic primary
+    };
+
+    /// A column that queries can use, by name
+    struct Column {
+        const char* name;
+        const char* description;
+        double (*get)(const Row&);
+    };
+    static const std::vector<Column>& GetColumns();
+    /// Index in GetColumns(), -1 if unknown
+    static int FindColumn(const std::string& name);
+
+    /// Compute the summary of all events of a file, with `nThreads` threads (0 = all cores)
+    bool Build(const std::string& filename, unsigned nThreads = 0);
+
+    /// Read a sidecar file, fails if missing or built for a different key.
+    bool Load(const std::string& path, const EventIndex::Key& key);
+    /// Write the summary to a sidecar file.
+    bool Save(const std::string& path, const EventIndex::Key& key) const;
+    /// Sidecar file for a given key inside the cache directory (empty if no cache).
+    static std::string SidecarPath(const EventIndex::Key& key);
+
+    const std::vector<Row>& GetRows() const { return rows_; } // sorted by evtID
+    std::size_t Size() const { return rows_.size(); }
+    void Clear() { rows_.clear(); }
+
+private:
+    std::vector<Row> rows_;
+
+    /// Build from a CompactEventFile
+    bool BuildCompact(const std::string& filename);
+};
+
+#endif // EVENTSUMMARY_H
@@ -4,12 +4,18 @@
 #include <string>
 #include <vector>
 
+#include "GeometryBudget.hh"
 #include "GeometryManager.hh"
+#include "ImageWriter.hh"
 #include "DataManager.hh"
 #include "MultiView.hh"
 
 #include "TGLabel.h"
 #include "TGTextEntry.h"
+#include "TGNumberEntry.h"
+#include "TGButton.h"
+#include "TEveElement.h"
+#include "TTimer.h"
 
 /**
  * Sets up the TEve GUI: multi‐view (3D, ZX, ZY) + a Controls tab
@@ -20,14 +26,44 @@ public:
     GUIDisplay();
     ~GUIDisplay();
 
-    /// Initialize TEve and build all GUI elements
-    void Initialize(const std::string& title);
+    /// Initialize TEve and build all GUI elements.
+    /// In batch mode the windows are not mapped and there is no control tab.
+    void Initialize(const std::string& title, bool batch = false);
+
+    /// Render one event off-screen to FormatEventFileName(pattern, evtID),
+    /// in a sub-directory named after its data file when several are chained
+    bool RenderEvent(const EventRef& event, const std::string& pattern, int scale = 1);
+
+    /// Render the given events off-screen to FormatEventFileName(pattern, evtID),
+    /// one image per view (_mv3D, _mvZX, _mvZY). Only the event scenes are rebuilt
+    /// between events. Returns the number of events that failed.
+    int RenderEvents(const std::vector<EventRef>& events, const std::string& pattern, int scale = 1);
 
     /// Load only geometry (GDML)
     void LoadGeometry(const std::string& gdmlFile, const bool useDefault = false);
 
-    /// Load data (ROOT) file
-    void LoadFile(const std::string& rootFile);
+    /// Level of detail of the geometry extract
+    void SetGeometryLOD(const GeometryLOD& lod);
+
+    /// Triangles drawn at most for the geometry in the 3D, ZX and ZY viewers, 0 = no limit
+    void SetTriangleBudgets(Long64_t budget3D, Long64_t budgetZX, Long64_t budgetZY);
+
+    /// Detectors shown at start, by GeometryManager::GetDetectors() name; all if empty
+    void SetDetectors(const std::vector<std::string>& names);
+
+    /// Use another geometry style file than config/geometry_style.txt
+    void SetGeometryStyle(const std::string& styleFile);
+
+    /// Load data (ROOT) files, chained in order, wildcards allowed
+    void LoadFiles(const std::vector<std::string>& rootFiles);
+
+    /// Size of the decoded event cache, number of events prefetched around the current one
+    /// and number of data files kept open
+    void SetCacheOptions(int sizeMB, int prefetchDepth, int maxOpenFiles = 16);
+
+    /// Trajectory points built per chunk of an event, between two redraws
+    /// (0 = whole events at once), and at most for an event (0 = no cap)
+    void SetBuildOptions(Long64_t chunkVertices, Long64_t maxVertices);
 
     /// Called when Next/Prev buttons fire
     void OnNextEvent();
@@ -36,26 +72,101 @@ public:
     /// Called when "Save" button fires
     void OnSave();
 
+    /// Save the four displays as one tiled image instead of four files
+    void SetTiledExport(bool tiled) { tiledExport_ = tiled; }
+
+    /// Called when a cut entry changes
+    void OnCutsChanged();
+
+    /// Called when a query is entered: navigate only the events it selects
+    void OnQuery();
+
+    /// Called when "Go" fires: jump to the evtID entered
+    void OnGoToEvent();
+
+    /// Called when "Search all files" fires: index the other files to find the evtID
+    void OnSearchAllFiles();
+
+    /// Called when a detector check button is toggled
+    void OnDetectorToggled();
+
+    /// Called by the build timer: add the next chunk of tracks of the event
+    void OnBuildTick();
+
+    /// Called by the load timer: show the requested event once it is decoded
+    void OnLoadTick();
+
+    /// Called by the search timer: jump to the evtID once a file holds it
+    void OnSearchTick();
+
     ClassDef(GUIDisplay, 0)  // ROOT dictionary for signal/slot
 
 private:
     GeometryManager geomMgr_;
+    GeometryBudget geomBudget_;
+    Long64_t triangleBudgets_[3] = {0, 0, 0}; // 3D, ZX, ZY
+
+    /// Gentle geometry of a detector in the three viewers, imported when first shown
+    struct DetectorView {
+        bool loaded = false;
+        bool shown = false;
+        TEveElement* gentle = nullptr;
+        TEveElement* zx = nullptr;
+        TEveElement* zy = nullptr;
+        TGCheckButton* button = nullptr;
+    };
+    std::vector<std::string> detectorsRequested_;
+    std::vector<DetectorView> detectorViews_; // as GeometryManager::GetDetectors()
+    TEveElementList* geometry_ = nullptr;
+    TEveElement* geometryZX_ = nullptr;
+    TEveElement* geometryZY_ = nullptr;
     DataManager dataMgr_;
     MultiView *mv_;
-    TGLabel* summaryView_;
+    TGLabel* summaryView_ = nullptr;
     TGTextEntry* filenameEntry_;
+    TGNumberEntry* kinECutEntry_;
+    TGNumberEntry* lengthCutEntry_;
+    TGTextEntry* queryEntry_ = nullptr;
+    TGLabel* queryStatus_ = nullptr;
+    TGNumberEntry* gotoEntry_ = nullptr;
     
     int imageScale_ = 0; // for saving
+    bool tiledExport_ = false;
+    TGCheckButton* tiledCheck_ = nullptr;
+    ImageWriter imageWriter_;
+    int nRendered_ = 0;  // headless rendering
+    bool batch_ = false;
+    TTimer* buildTimer_ = nullptr; // progressive event building
+    TTimer* loadTimer_ = nullptr;  // polls events decoded in the background
+    TTimer* searchTimer_ = nullptr; // polls SearchAllFiles()
+    TGLabel* loadingLabel_ = nullptr;
 
     /// Build control tab
     void MakeControlTab();
 
-    /// Load a new data event
-    void LoadEvent();
+    /// Show the event jumped to, dropping the query if it does not select it
+    void ShowJumpedEvent();
+
+    /// Load a new data event, false if it could not be read
+    bool LoadEvent();
+
+    /// Load the selected event in the background, superseding a pending
+    /// load; synchronous in batch mode
+    void RequestEvent();
+
+    /// Project and redraw the tracks of the event, then finish building it:
+    /// at once in batch mode, else chunk by chunk on timer ticks
+    void ShowEvent();
 
     /// Update summary text
     void UpdateSummary();
 
+    /// Show or hide a detector, importing and projecting its geometry the first time
+    void ShowDetector(std::size_t d, bool show);
+
+    /// Apply the triangle budgets to the shown detectors
+    void ApplyGeometryBudgets();
+
 };
 
 #endif // GUIDISPLAY_H
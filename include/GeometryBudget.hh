@@ -0,0 +1,46 @@
+#ifndef GEOMETRYBUDGET_H
+#define GEOMETRYBUDGET_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "TEveElement.h"
+#include "TEveGeoShape.h"
+
+/**
+ * Triangle counts of an imported gentle geometry, and per-viewer
+ * triangle budgets: the largest shapes are kept within the budget,
+ * the smaller ones are not drawn.
+ */
+class GeometryBudget {
+public:
+    /// Set the tube/cone segments of all shapes below `gentle` (if > 0)
+    /// and count the triangles of the shapes drawn by default
+    void Add(TEveElement* gentle, Int_t nSegments);
+
+    /// Apply a budget to `top`, the gentle geometry or one of its projections,
+    /// and log the shape and triangle counts per detector (the children of `top`,
+    /// skipped if hidden). 0 means no budget.
+    /// Projected shapes are costed with the triangles of their 3D shape, an upper bound.
+    /// Hiding a 3D shape also hides its projections: apply the 3D budget first.
+    /// Returns the number of triangles drawn.
+    Long64_t Apply(TEveElement* top, Long64_t budget, const std::string& viewer);
+
+    /// Triangles of the tessellated shape, its daughters excluded
+    static Long64_t CountTriangles(TEveGeoShape* shape);
+
+private:
+    struct Shape {
+        TEveElement* element;
+        Float_t size;      // largest extent, cm
+        Long64_t triangles;
+        int detector;      // index in the detector names
+    };
+
+    std::unordered_map<TEveGeoShape*, Long64_t> triangles_; // drawable shapes
+
+    void AddShape(TEveElement* el, int detector, std::vector<Shape>& shapes) const;
+    void Collect(TEveElement* el, int detector, std::vector<Shape>& shapes) const;
+};
+
+#endif // GEOMETRYBUDGET_H
@@ -6,6 +6,19 @@
 #include "TGeoNode.h"
 #include "TEveGeoNode.h"
 #include "TEveGeoShape.h"
+#include "TEveElement.h"
+
+#include "GeometryStyle.hh"
+
+/**
+ * Level of detail of the gentle geometry extract
+ */
+struct GeometryLOD {
+    double minSize = 0;     ///< cm, volumes whose largest extent is smaller are not extracted
+    int mergeRepeated = 0;  ///< a daughter volume placed at least this many times is merged into its mother, 0 = never
+    int nSegments = 0;      ///< segments of tubes/cones, 0 = ROOT default
+    int maxDepth = 0;       ///< deepest level extracted below the hall, 0 = all
+};
 
 /**
  * Loads a GDML geometry file into the global TGeoManager
@@ -23,26 +36,71 @@ public:
     /// Use default colors/transparencies 
     void UseDefault(const bool value) { leaveDefault_ = value; }
 
+    /// Level of detail of the gentle geometry
+    void SetLOD(const GeometryLOD& lod) { lod_ = lod; }
+    const GeometryLOD& GetLOD() const { return lod_; }
+
+    /// Styling rules of the detector volumes, see config/geometry_style.txt
+    void SetStyleFile(const std::string& file) { styleFile_ = file; }
+
     /// Get the top “hall” node
-    TEveGeoTopNode *GetTopNode() const;
+    TEveGeoTopNode *GetTopNode();
+
+    /// Detectors that can be loaded separately, and the name of their
+    /// physical volume in the hall ("" for all the other hall daughters)
+    struct Detector {
+        std::string name;
+        std::string physical;
+    };
+    static const std::vector<Detector>& GetDetectors();
 
-    /// Import a simplified (gentle) geometry that works with projections
+    /// Import the simplified (gentle) geometry of one detector, that works with projections,
+    /// extracting it from the GDML only if it is not cached yet. nullptr if it has no volumes.
     /// see https://root-forum.cern.ch/t/axes-dont-show-up-in-the-projection-of-a-imported-gdml-geometry-in-eve/40484
-    TEveGeoShape* ImportGentleGeometry();
+    TEveElementList* ImportGentleGeometry(const std::string& detector);
 
     /// Get the direct daughter nodes of the main “hall” volume
-    const std::vector<TGeoNode *> &GetDetectorNodes() const;
+    const std::vector<TGeoNode *> &GetDetectorNodes();
 
 private:
-    TGeoNode *hallNode_;
+    TGeoNode *hallNode_ = nullptr;
     std::vector<TGeoNode *> detectorNodes_;
-    std::string gentleGeoFile_;
+    std::string gdmlFile_;
+    std::string gentleKey_;
+    bool styled_ = false;
     bool leaveDefault_ = false;
+    std::string styleFile_;
+    GeometryStyle style_;
+    GeometryLOD lod_;
+
+    /// Compile the styling rules: fixed envelope transparencies + style file
+    void LoadStyle();
+
+    /// Import the GDML into gGeoManager, only done when needed:
+    /// a cached gentle geometry does not need it
+    void ImportGDML();
+
+    /// Cache key of the gentle geometry: GDML contents + styling options
+    std::string GentleKey() const;
 
     void PrintHierarchyTree(TGeoNode *node, int maxDepth, int level, bool skipAssemblies);
 
-    /// Extract a simplified (gentle) geometry that works with projections
-    void ExtractGentleGeometry();
+    /// Cached gentle geometry of a detector
+    std::string GentlePath(const std::string& detector) const;
+
+    /// Whether a daughter of the hall belongs to a detector
+    static bool IsDetectorNode(const std::string& detector, TGeoNode* node);
+
+    /// Extract the simplified (gentle) geometry of a detector to `file`
+    void ExtractGentleGeometry(const std::string& detector, const std::string& file);
+
+    /// Counts of the nodes left out of the extract by the LOD options
+    struct ExtractStats {
+        int extracted = 0, culled = 0, merged = 0;
+    };
+
+    /// Add the daughters of `parent` kept by the LOD options, recursively
+    void ExpandNode(TEveGeoNode* parent, int depth, ExtractStats& stats);
 };
 
 #endif // GEOMETRYMANAGER_H
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef GEOMETRYSTYLE_H
+#define GEOMETRYSTYLE_H
+
+#include <istream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "Rtypes.h"
+#include "TGeoNode.h"
+#include "TGeoVolume.h"
+
+/**
+ * Table of styling rules (node path pattern, depth range, colour,
+ * transparency) applied to a geometry tree in a single traversal,
+ * visiting each unique TGeoVolume once.
+ */
+class GeometryStyle {
+public:
+    struct Rule {
+        std::string pattern;   // shell pattern on the path below the top node
+        int minDepth;          // 0 is the top node itself
+        int maxDepth;
+        Color_t color;         // -1 to keep it
+        Int_t transparency;    // -1 to keep it
+    };
+
+    void AddRule(const Rule& rule);
+
+    /// Read rules from a file, see config/geometry_style.txt for the format
+    bool Load(const std::string& filename);
+    /// Read rules from a stream, `source` is only used in messages
+    bool Parse(std::istream& in, const std::string& source);
+
+    /// Normalized text of all rules, to key caches on
+    std::string GetKey() const;
+
+    std::size_t Size() const { return rules_.size(); }
+
+    /// Style the volumes below `top`, returns the number of styled volumes
+    int Apply(TGeoNode* top) const;
+
+private:
+    std::vector<Rule> rules_;
+    int maxDepth_ = -1;
+
+    void ApplyNode(TGeoNode* node, int depth, std::string& path,
+                   std::unordered_set<TGeoVolume*>& visited, int& nShared) const;
+};
+
+#endif // GEOMETRYSTYLE_H
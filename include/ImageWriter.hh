@@ -0,0 +1,65 @@
+#ifndef IMAGEWRITER_H
+#define IMAGEWRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Rtypes.h"
+
+class TGLViewer;
+
+/**
+ * Writes viewer captures as PNG files on a background thread.
+ * Only grabbing the pixels has to happen on the GUI thread,
+ * the encoding and file writes do not block it.
+ * Pending images are still written when the program exits.
+ */
+class ImageWriter {
+public:
+    struct Image {
+        std::string name;          // output file
+        UInt_t width = 0;
+        UInt_t height = 0;
+        std::vector<UInt_t> argb;  // row by row, top row first
+    };
+
+    ImageWriter();
+    ~ImageWriter();
+
+    /// Copy the pixels of a viewer, on the GUI thread. With a scale above 0
+    /// it is rendered off-screen at `scale` times its size, as SavePictureScale.
+    static bool Grab(TGLViewer* viewer, int scale, const std::string& name, Image& image);
+
+    /// Write each image to its own file in the background
+    void Write(std::vector<Image> images);
+    /// Write the images as one file in the background, tiled `columns` per row
+    void WriteTiled(std::vector<Image> images, int columns, const std::string& name);
+
+    /// Wait until all queued images are written
+    void Wait();
+
+    /// Encode an image as PNG, on the calling thread
+    static bool WritePNG(const Image& image);
+    /// Put images together, `columns` per row, each in a cell of the largest image size
+    static Image Tile(const std::vector<Image>& images, int columns, const std::string& name);
+
+private:
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> jobs_;
+    int running_ = 0;
+    bool stop_ = false;
+
+    void Push(std::function<void()> job);
+    void Loop();
+
+    /// Pending images are written before exit(), also from TApplication::Terminate
+    static void WaitAll();
+};
+
+#endif // IMAGEWRITER_H
@@ -1,3 +1,6 @@
 #ifdef __CLING__
 #pragma link C++ class GUIDisplay+;
+#pragma link C++ class TrackBatch+;
+#pragma link C++ class TrackBatchProjected+;
+#pragma link C++ class TrackBatchGL+;
 #endif
@@ -7,6 +7,8 @@
 #include "TEveViewer.h"
 #include "TEveScene.h"
 
+#include "ImageWriter.hh"
+
 /**
  * MultiView: encapsulates a 3-panel (3D, Z–X, Z–Y) display
  * using the EVE Window Manager APIs, mirroring ROOT's tutorial.
@@ -33,16 +35,28 @@ struct MultiView {
    // Convenience: set the projection depth
    void SetDepth(Float_t d);
 
-   // Import one TEveElement into the geom/event scenes
-   void ImportGeomZX(TEveElement* el);
-   void ImportGeomZY(TEveElement* el);
-   void ImportEventZX(TEveElement* el);
-   void ImportEventZY(TEveElement* el);
-   void DestroyEventZX();
-   void DestroyEventZY();
+   // Import one TEveElement into the geom scenes and return the
+   // projected element, added to `parent` (a projected element)
+   // instead of the scene if given
+   TEveElement* ImportGeomZX(TEveElement* el, TEveElement* parent = nullptr);
+   TEveElement* ImportGeomZY(TEveElement* el, TEveElement* parent = nullptr);
+
+   // Project the event top `el` into the event scenes: its elements
+   // projected before are updated in place, only new ones are imported
+   void UpdateEventZX(TEveElement* el);
+   void UpdateEventZY(TEveElement* el);
+
+   /// Save current displays as images, false if any of them failed.
+   /// A scale above 0 renders off-screen, also when the windows are not mapped
+   bool SaveDisplays(std::string base, std::string ext, int scale=0);
+
+   /// Grab the current displays, named as by SaveDisplays, to write them later
+   bool GrabDisplays(std::string base, std::string ext, int scale, std::vector<ImageWriter::Image>& images);
 
-   /// Save current displays as images 
-   void SaveDisplays(std::string base, std::string ext, int scale=0);
+private:
+   void UpdateEvent(TEveProjectionManager* mgr, TEveScene* scene, TEveElement* el);
+   void SyncProjected(TEveProjectionManager* mgr, TEveElement* el, TEveElement* proj);
+   void Reproject(TEveElement* proj);
 
 };
 
@@ -0,0 +1,50 @@
+#ifndef RENDERPOOL_H
+#define RENDERPOOL_H
+
+#include <functional>
+#include <vector>
+
+/**
+ * Renders a list of events with several worker processes.
+ * TEve and gEve are singletons, so each worker is a forked process with
+ * its own display. Workers take chunks of events from a queue in shared
+ * memory and report each event back to the parent through a pipe.
+ * The first worker sets up alone, so that the others find the geometry
+ * and event index in the cache directory. Events a worker claimed but
+ * never started, because it died, are rendered again in another pass.
+ */
+class RenderPool {
+public:
+    /// Called once in each worker before its first event, false on failure
+    typedef std::function<bool()> Setup_t;
+    /// Render one event in a worker, false on failure
+    typedef std::function<bool(int evtID)> Render_t;
+
+    RenderPool(int nWorkers, int chunkSize = 8);
+
+    /// Render all events, returns the number of events not rendered
+    int Run(const std::vector<int>& events, const Setup_t& setup, const Render_t& render);
+
+private:
+    int nWorkers_;
+    int chunkSize_;
+
+    /// One pass over `events` with fresh workers, returns the number of events
+    /// rendered; the events no worker started are added to `unstarted`
+    int RunPass(const std::vector<int>& events, const Setup_t& setup, const Render_t& render,
+                std::vector<int>& unstarted);
+
+    /// Message from a worker to the parent, written atomically to its pipe
+    struct Message {
+        enum Type : int { kReady, kStart, kDone, kFailed, kSetupFailed };
+        int type;
+        int evtID;
+        int index; // position of the event in the list
+        float ms;
+    };
+
+    /// Body of a worker process, never returns
+    [[noreturn]] void Work(int fd, const std::vector<int>& events, const Setup_t& setup, const Render_t& render);
+};
+
+#endif // RENDERPOOL_H
@@ -0,0 +1,79 @@
+#ifndef STAGETIMER_H
+#define STAGETIMER_H
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Latency of the named processing stages (event read, projection, ...):
+ * last value and a log-binned histogram per stage, optionally each
+ * measurement as a newline-delimited JSON record in a log file.
+ * A report of all stages is printed at exit.
+ */
+class StageStats {
+public:
+    static StageStats& Instance();
+
+    /// Add a measurement, `evtID` < 0 if not related to an event
+    void Record(const std::string& stage, double ms, int evtID = -1);
+
+    /// Append every measurement to this NDJSON file, "" to stop
+    bool SetLogFile(const std::string& path);
+
+    /// Last value of a stage in ms, negative if never measured
+    double GetLast(const std::string& stage) const;
+
+    /// One line with the last values of the given stages
+    std::string GetSummary(const std::vector<std::string>& stages) const;
+
+    /// Count, mean, percentiles and max of all stages
+    std::string GetReport() const;
+
+    /// The same as a JSON object keyed by stage name, for tools
+    std::string GetJSON() const;
+
+private:
+    // bucket i holds [kMinMs * 10^(i/8), kMinMs * 10^((i+1)/8)), 1 us to 100 s
+    static constexpr int kBuckets = 64;
+    static constexpr double kMinMs = 1e-3;
+
+    struct Stage {
+        double last = 0, sum = 0, max = 0;
+        long count = 0;
+        std::array<long, kBuckets> buckets{};
+        double Percentile(double q) const;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Stage> stages_;
+    std::ofstream log_;
+
+    StageStats() = default;
+};
+
+/**
+ * Measures the time until it goes out of scope (or Stop())
+ * and records it in StageStats under the stage name.
+ */
+class StageTimer {
+public:
+    explicit StageTimer(const char* stage, int evtID = -1)
+        : stage_(stage), evtID_(evtID), start_(std::chrono::steady_clock::now()) {}
+    ~StageTimer() { Stop(); }
+
+    /// Record now, returns the elapsed ms
+    double Stop();
+
+private:
+    const char* stage_;
+    int evtID_;
+    std::chrono::steady_clock::time_point start_;
+    bool stopped_ = false;
+};
+
+#endif // STAGETIMER_H
@@ -0,0 +1,169 @@
+#ifndef TRACKBATCH_H
+#define TRACKBATCH_H
+
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "TNamed.h"
+#include "TAtt3D.h"
+#include "TAttBBox.h"
+#include "TAttLine.h"
+#include "TEveElement.h"
+#include "TEveProjectionBases.h"
+
+#include "EventData.hh"
+
+class TGLSelectRecord;
+
+/**
+ * All selected tracks of an event as a single TEve element,
+ * drawn by TrackBatchGL in one pass from a shared vertex buffer
+ * with per-vertex colours from the PDG style table.
+ * Individual tracks can still be picked and highlighted.
+ */
+class TrackBatch : public TEveElement,
+                   public TNamed,
+                   public TAtt3D,
+                   public TAttBBox,
+                   public TAttLine,
+                   public TEveProjectable
+{
+public:
+    /// Tracks drawn with the same line style and width, contiguous in the batch
+    struct StyleGroup {
+        Style_t style;
+        Width_t width;
+        Int_t   begin; // first track of the group
+        Int_t   end;   // one past the last track of the group
+    };
+
+    /// Vertex buffers of the tracks at one simplification tolerance
+    struct Level {
+        Float_t tolerance;             // cm, 0 for the full trajectories
+        std::vector<Float_t> vertices; // x,y,z of all points, track by track
+        std::vector<UChar_t> colors;   // rgba of each point
+        std::vector<Int_t>   first;    // first vertex of each track
+        std::vector<Int_t>   count;    // number of vertices of each track
+        std::vector<Int_t>   drawFirst; // first/count of the visible tracks only,
+        std::vector<Int_t>   drawCount; // in the order of GetDrawTracks()
+    };
+
+    typedef std::set<Int_t> SelectionSet_t;
+
+    TrackBatch(const char* name = "Tracks");
+    virtual ~TrackBatch() {}
+
+    /// Fill the batch with the given tracks of an event
+    void SetTracks(const std::shared_ptr<const EventData>& data, const std::vector<uint32_t>& tracks);
+    /// Append more tracks of the same event, shown; the projections
+    /// only project the new ones on their next update
+    void AddTracks(const std::vector<uint32_t>& tracks);
+    /// Remove all tracks
+    void Reset();
+
+    /// Simplification tolerances of the levels of detail, finest first
+    static const std::vector<Float_t>& GetLODTolerances();
+
+    /// Show only the tracks flagged in `visible`, indexed like the EventData tracks.
+    /// Vertex buffers and projections are kept, only the draw lists are rebuilt.
+    /// Returns the number of tracks whose visibility changed.
+    Int_t SetVisibility(const std::vector<UChar_t>& visible);
+
+    Int_t GetNTracks() const { return tracks_.size(); }
+    Int_t GetNVisible() const { return drawTracks_.size(); }
+    Bool_t IsVisible(Int_t i) const { return visible_[i]; }
+    Int_t GetNLevels() const { return levels_.size(); }
+    const Level& GetLevel(Int_t l) const { return levels_[l]; }
+    /// Vertices of the visible tracks at a given level
+    Int_t GetNVertices(Int_t l = 0) const;
+
+    // visible tracks, grouped by style, as drawn by TrackBatchGL
+    const std::vector<Int_t>& GetDrawTracks() const { return drawTracks_; }
+    const std::vector<StyleGroup>& GetDrawGroups() const { return drawGroups_; }
+
+    /// Coarsest level that looks the same when a pixel spans `pixelSize` cm
+    Int_t SelectLevel(Float_t pixelSize) const;
+
+    /// Index of a batch track in the EventData it was filled from
+    uint32_t GetEventTrack(Int_t i) const { return tracks_[i]; }
+    const EventData* GetEventData() const { return data_.get(); }
+
+    // selection of individual tracks, shared with the projected batches
+    virtual TrackBatch& GetSelectionOwner() { return *this; }
+    SelectionSet_t& RefSelectedSet() { return selectedSet_; }
+    SelectionSet_t& RefHighlightedSet() { return highlightedSet_; }
+    void ProcessGLSelection(TGLSelectRecord& rec);
+
+    /// Print the properties of a picked track
+    void TrackPicked(Int_t i) const;
+
+    virtual void ComputeBBox();
+    virtual void Paint(Option_t* option = "");
+    virtual TClass* ProjectedClass(const TEveProjection* p) const;
+
+protected:
+    std::vector<Level>   levels_;   //!
+    std::vector<uint32_t> tracks_;  //! index of each track in data_
+    std::vector<StyleGroup> groups_; //! all tracks
+    std::vector<UChar_t> visible_;   //!
+    std::vector<Int_t> drawTracks_;  //! visible tracks
+    std::vector<StyleGroup> drawGroups_; //! groups of drawTracks_
+    std::shared_ptr<const EventData> data_; //!
+    UInt_t generation_ = 0; //! changes with each SetTracks/Reset, not with AddTracks
+
+    SelectionSet_t selectedSet_;    //!
+    SelectionSet_t highlightedSet_; //!
+
+    /// Tell the GL renderers of this batch and its projections to redraw
+    void StampSelection();
+
+    /// Compact the visible tracks into the draw lists
+    void RebuildDrawLists();
+
+    /// Copy everything but the vertices from another batch
+    void CopyLayout(const TrackBatch& o);
+    /// Copy the visibility and draw lists from another batch
+    void CopyDrawLists(const TrackBatch& o);
+
+    ClassDef(TrackBatch, 0); // Tracks of an event drawn as one object
+};
+
+/**
+ * Projection of a TrackBatch in a 2D view (ZX, ZY).
+ * Picking and highlighting are forwarded to the original batch.
+ */
+class TrackBatchProjected : public TrackBatch,
+                            public TEveProjected
+{
+public:
+    TrackBatchProjected();
+    virtual ~TrackBatchProjected() {}
+
+    virtual void SetProjection(TEveProjectionManager* mng, TEveProjectable* model);
+    /// Project all the tracks again
+    virtual void UpdateProjection();
+    virtual TEveElement* GetProjectedAsElement() { return this; }
+
+    /// Project only the tracks appended to the original since the last
+    /// projection, or all of them for a new event. Only valid if the
+    /// projection did not change in between: TEve calls UpdateProjection then
+    void ProjectAppended();
+
+    virtual TrackBatch& GetSelectionOwner();
+
+    /// Follow a visibility change of the original batch, without projecting again
+    void UpdateVisibility();
+
+protected:
+    virtual void SetDepthLocal(Float_t d);
+
+    UInt_t projectedGeneration_ = 0; //! generation_ of the original when last projected
+
+    /// Project the tracks from the nDone-th on, the previous ones are kept
+    void Project(std::size_t nDone);
+
+    ClassDef(TrackBatchProjected, 0); // Projected TrackBatch
+};
+
+#endif // TRACKBATCH_H
@@ -0,0 +1,43 @@
+#ifndef TRACKBATCHGL_H
+#define TRACKBATCHGL_H
+
+#include "TGLObject.h"
+#include "TrackBatch.hh"
+
+/**
+ * GL renderer of a TrackBatch: one glMultiDrawArrays call per
+ * line style over the shared vertex and colour arrays, using the
+ * coarsest level of detail that is exact to half a pixel for the
+ * camera of the viewer being drawn.
+ * Tracks are named individually only in the secondary selection pass.
+ */
+class TrackBatchGL : public TGLObject
+{
+public:
+    TrackBatchGL();
+    virtual ~TrackBatchGL() {}
+
+    virtual Bool_t SetModel(TObject* obj, const Option_t* opt = 0);
+    virtual void   SetBBox();
+
+    virtual void   DirectDraw(TGLRnrCtx& rnrCtx) const;
+    virtual void   DrawHighlight(TGLRnrCtx& rnrCtx, const TGLPhysicalShape* pshp, Int_t lvl = -1) const;
+    virtual Bool_t ShouldDLCache(const TGLRnrCtx& rnrCtx) const;
+
+    virtual Bool_t IgnoreSizeForOfInterest() const { return kTRUE; }
+
+    virtual Bool_t SupportsSecondarySelect() const { return kTRUE; }
+    virtual Bool_t AlwaysSecondarySelect() const { return kTRUE; }
+    virtual void   ProcessSelection(TGLRnrCtx& rnrCtx, TGLSelectRecord& rec);
+
+protected:
+    TrackBatch* model_;
+    mutable const TrackBatch::SelectionSet_t* highlightSet_;
+
+    /// Level of detail for the current camera
+    Int_t SelectLevel(TGLRnrCtx& rnrCtx) const;
+
+    ClassDef(TrackBatchGL, 0); // GL renderer of TrackBatch
+};
+
+#endif // TRACKBATCHGL_H
@@ -0,0 +1,14 @@
+#ifndef TRACKQUANTITIES_H
+#define TRACKQUANTITIES_H
+
+#include "EventData.hh"
+
+/**
+ * Fill the per-track quantities of an EventData (polyline length,
+ * end-to-end displacement, bounding box) in a single pass over the
+ * point arrays. The loops are written to be auto-vectorized; this
+ * file is compiled with relaxed floating point semantics for that.
+ */
+void ComputeTrackQuantities(EventData& data);
+
+#endif // TRACKQUANTITIES_H
@@ -0,0 +1,15 @@
+#ifndef TRACKSIMPLIFY_H
+#define TRACKSIMPLIFY_H
+
+#include "EventData.hh"
+
+/**
+ * Ramer-Douglas-Peucker significance of every trajectory point:
+ * the point is kept by RDP simplification with tolerance `tol`
+ * (same units as the points, cm) if and only if significance > tol.
+ * Track end points get FLT_MAX. Computed once for all tolerances,
+ * tracks are processed in parallel for large events.
+ */
+void ComputeSignificance(EventData& data);
+
+#endif // TRACKSIMPLIFY_H
@@ -0,0 +1,18 @@
+#ifndef TRACKSTYLE_H
+#define TRACKSTYLE_H
+
+#include "Rtypes.h"
+
+/**
+ * Line attributes used to draw a track of a given particle type.
+ */
+struct TrackStyle {
+    Color_t color;
+    Style_t style;
+    Width_t width;
+};
+
+/// Style of a track given its PDG code
+TrackStyle GetTrackStyle(int pdg);
+
+#endif // TRACKSTYLE_H
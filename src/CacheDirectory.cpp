@@ -0,0 +1,112 @@
+#include "CacheDirectory.hh"
+
+#include <cstring>
+#include <iostream>
+
+#include "TString.h"
+#include "TSystem.h"
+
+std::string GetCacheDirectory()
+{
+    std::string dir;
+    if (const char* env = gSystem->Getenv("FPFDISPLAY_CACHE_DIR")) {
+        dir = env;
+    } else if (const char* xdg = gSystem->Getenv("XDG_CACHE_HOME")) {
+        dir = std::string(xdg) + "/fpfdisplay";
+    } else {
+        dir = std::string(gSystem->HomeDirectory()) + "/.cache/fpfdisplay";
+    }
+
+    // AccessPathName returns true if the path does NOT exist...
+    if (gSystem->AccessPathName(dir.c_str()) && gSystem->mkdir(dir.c_str(), kTRUE) != 0) {
+        std::cerr << "[CacheDirectory] Could not create cache directory " << dir << std::endl;
+        return "";
+    }
+    if (gSystem->AccessPathName(dir.c_str(), kWritePermission)) {
+        std::cerr << "[CacheDirectory] Cache directory " << dir << " is not writable" << std::endl;
+        return "";
+    }
+    return dir;
+}
+
+std::string GetCacheFile(const std::string& dataFile, const std::string& extension)
+{
+    std::string dir = GetCacheDirectory();
+    if (dir.empty()) return "";
+    return dir + "/" + TString(dataFile.c_str()).MD5().Data() + extension;
+}
+
+bool OpenSidecar(const std::string& path, const SidecarFormat& format, const EventIndex::Key& key,
+                 std::ifstream& in, uint64_t& n)
+{
+    if (path.empty()) return false;
+
+    in.open(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    const uint64_t fileSize = in.tellg();
+    in.seekg(0);
+
+    char magic[8];
+    uint32_t version = 0, recordSize = 0, uuidSize = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&recordSize), sizeof(recordSize));
+    if (!in || std::memcmp(magic, format.magic, sizeof(magic)) != 0 ||
+        version != format.version || recordSize != format.recordSize)
+        return false;
+
+    EventIndex::Key stored;
+    in.read(reinterpret_cast<char*>(&uuidSize), sizeof(uuidSize));
+    if (!in || uuidSize > 256) return false;
+    stored.uuid.resize(uuidSize);
+    in.read(&stored.uuid[0], uuidSize);
+    in.read(reinterpret_cast<char*>(&stored.size), sizeof(stored.size));
+    in.read(reinterpret_cast<char*>(&stored.mtime), sizeof(stored.mtime));
+    if (!in || !(stored == key)) {
+        std::cout << "[CacheDirectory] Sidecar " << path << " is stale, rebuilding" << std::endl;
+        return false;
+    }
+
+    in.read(reinterpret_cast<char*>(&n), sizeof(n));
+    if (!in) return false;
+    const uint64_t left = fileSize - in.tellg();
+    return n <= left / recordSize;
+}
+
+bool WriteSidecar(const std::string& path, const SidecarFormat& format, const EventIndex::Key& key,
+                  const void* records, uint64_t n)
+{
+    if (path.empty()) return false;
+
+    std::string tmp = path + Form(".tmp%d", gSystem->GetPid());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "[CacheDirectory] Could not write sidecar " << tmp << std::endl;
+            return false;
+        }
+
+        const uint32_t uuidSize = key.uuid.size();
+        out.write(format.magic, 8);
+        out.write(reinterpret_cast<const char*>(&format.version), sizeof(format.version));
+        out.write(reinterpret_cast<const char*>(&format.recordSize), sizeof(format.recordSize));
+        out.write(reinterpret_cast<const char*>(&uuidSize), sizeof(uuidSize));
+        out.write(key.uuid.data(), uuidSize);
+        out.write(reinterpret_cast<const char*>(&key.size), sizeof(key.size));
+        out.write(reinterpret_cast<const char*>(&key.mtime), sizeof(key.mtime));
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        out.write(static_cast<const char*>(records), n * format.recordSize);
+        if (!out) {
+            std::cerr << "[CacheDirectory] Could not write sidecar " << tmp << std::endl;
+            out.close();
+            gSystem->Unlink(tmp.c_str());
+            return false;
+        }
+    }
+
+    if (gSystem->Rename(tmp.c_str(), path.c_str()) != 0) {
+        gSystem->Unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,407 @@
+#include "CompactEventFile.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    // bump the version whenever the layout changes
+    const char     kCompactMagic[8] = {'F','P','F','E','V','D','\0','\0'};
+    const uint32_t kCompactVersion  = 2;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t eventSize;   // sizeof(CompactEventFile::Event)
+        double quantum;       // cm
+        uint64_t nEvents;
+        uint64_t tableOffset; // 8-byte aligned
+        char reserved[24];
+    };
+    static_assert(sizeof(Header) == 64, "the header layout is part of the file format");
+
+    /// Track columns of an event, 4 bytes each: tid, pid, pdg, kinE, nPoints,
+    /// then the quantities of TrackQuantities
+    enum Column { kTID, kPID, kPDG, kKinE, kNPoints, kLength, kDisplacement,
+                  kXMin, kXMax, kYMin, kYMax, kZMin, kZMax, kNColumns };
+
+    uint64_t ColumnBytes(uint64_t nTracks) { return kNColumns * 4 * nTracks; }
+
+    inline uint64_t ZigZag(int64_t v) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+    inline int64_t UnZigZag(uint64_t v) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+    inline void PutVarint(std::vector<unsigned char>& out, uint64_t v)
+    {
+        while (v >= 0x80) {
+            out.push_back((unsigned char) (v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((unsigned char) v);
+    }
+
+    /// Decode one varint, false past `end` or on a malformed one
+    inline bool GetVarint(const unsigned char*& p, const unsigned char* end, uint64_t& v)
+    {
+        // one byte in most cases: steps shorter than 0.64 mm at 10 um
+        if (p < end && *p < 0x80) {
+            v = *p++;
+            return true;
+        }
+        v = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            const unsigned char b = *p++;
+            v |= uint64_t(b & 0x7f) << shift;
+            if (b < 0x80) return true;
+        }
+        return false;
+    }
+}
+
+CompactEventFile::~CompactEventFile()
+{
+    Close();
+}
+
+bool CompactEventFile::IsCompact(const std::string& filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    char magic[sizeof(kCompactMagic)];
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, kCompactMagic, sizeof(magic)) == 0;
+}
+
+bool CompactEventFile::Open(const std::string& filename)
+{
+    Close();
+
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "[CompactEventFile] Error opening file " << filename << std::endl;
+        return false;
+    }
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t) sizeof(Header))
+        map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file
+    if (map == MAP_FAILED) {
+        std::cerr << "[CompactEventFile] Could not map " << filename << std::endl;
+        return false;
+    }
+    base_ = static_cast<const char*>(map);
+    size_ = st.st_size;
+
+    Header header;
+    std::memcpy(&header, base_, sizeof(header));
+    if (std::memcmp(header.magic, kCompactMagic, sizeof(kCompactMagic)) != 0 || header.version != kCompactVersion ||
+        header.eventSize != sizeof(Event) || header.quantum <= 0 || header.tableOffset % 8 != 0 ||
+        header.tableOffset < sizeof(Header) || header.tableOffset > size_ ||
+        header.nEvents > (size_ - header.tableOffset) / sizeof(Event)) {
+        std::cerr << "[CompactEventFile] " << filename << " is not a valid version " << kCompactVersion << " compact event file" << std::endl;
+        Close();
+        return false;
+    }
+    quantum_ = header.quantum;
+    nEvents_ = header.nEvents;
+    table_ = reinterpret_cast<const Event*>(base_ + header.tableOffset);
+
+    // events are read in any order while browsing
+    madvise(const_cast<char*>(base_), size_, MADV_RANDOM);
+    return true;
+}
+
+void CompactEventFile::Close()
+{
+    if (base_) munmap(const_cast<char*>(base_), size_);
+    base_ = nullptr;
+    size_ = 0;
+    table_ = nullptr;
+    nEvents_ = 0;
+}
+
+CompactEventFile::Tracks CompactEventFile::GetTracks(std::size_t i) const
+{
+    const Event& e = table_[i];
+    const char* p = base_ + e.offset;
+    const std::size_t n = e.nTracks;
+    auto floats = [p, n](int c) { return reinterpret_cast<const float*>(p + 4 * n * c); };
+    return {reinterpret_cast<const int32_t*>(p + 4 * n * kTID),
+            reinterpret_cast<const int32_t*>(p + 4 * n * kPID),
+            reinterpret_cast<const int32_t*>(p + 4 * n * kPDG),
+            floats(kKinE),
+            reinterpret_cast<const uint32_t*>(p + 4 * n * kNPoints),
+            floats(kLength), floats(kDisplacement),
+            floats(kXMin), floats(kXMax), floats(kYMin), floats(kYMax), floats(kZMin), floats(kZMax)};
+}
+
+bool CompactEventFile::CheckEvent(std::size_t i) const
+{
+    if (i >= nEvents_) return false;
+    const Event& e = table_[i];
+    // a point takes 3 bytes at least: the point count is bounded before allocating
+    if (e.offset % 8 != 0 || e.offset < sizeof(Header) || e.offset > size_ || e.bytes > size_ - e.offset ||
+        ColumnBytes(e.nTracks) > e.bytes || e.nPoints > (e.bytes - ColumnBytes(e.nTracks)) / 3) {
+        std::cerr << "[CompactEventFile] Corrupted table entry for event " << e.evtID << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool CompactEventFile::GetFirstPoints(std::size_t i, std::vector<float>& x, std::vector<float>& y, std::vector<float>& z) const
+{
+    if (!CheckEvent(i)) return false;
+    const Event& e = table_[i];
+    const Tracks tracks = GetTracks(i);
+    x.assign(e.nTracks, 0);
+    y.assign(e.nTracks, 0);
+    z.assign(e.nTracks, 0);
+
+    // the point stream has no per-track offsets: skip the varints of each track
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(base_ + e.offset + ColumnBytes(e.nTracks));
+    const unsigned char* end = reinterpret_cast<const unsigned char*>(base_ + e.offset + e.bytes);
+    for (uint32_t t = 0; t < e.nTracks; ++t) {
+        uint64_t q[3];
+        for (uint32_t k = 0; k < tracks.nPoints[t]; ++k) {
+            if (!GetVarint(p, end, q[0]) || !GetVarint(p, end, q[1]) || !GetVarint(p, end, q[2])) return false;
+            if (k == 0) {
+                x[t] = UnZigZag(q[0]) * quantum_;
+                y[t] = UnZigZag(q[1]) * quantum_;
+                z[t] = UnZigZag(q[2]) * quantum_;
+            }
+        }
+    }
+    return true;
+}
+
+bool CompactEventFile::ReadEvent(std::size_t i, EventData& data, const std::atomic<bool>* cancel, int64_t maxPoints) const
+{
+    data.Clear();
+    if (!CheckEvent(i)) return false;
+
+    // the whole block is needed: one readahead rather than a fault per page
+    const Event& e = table_[i];
+    const uint64_t page = sysconf(_SC_PAGESIZE);
+    madvise(const_cast<char*>(base_) + e.offset / page * page, e.bytes + e.offset % page, MADV_WILLNEED);
+
+    const std::size_t n = e.nTracks;
+    const Tracks tracks = GetTracks(i);
+    uint64_t nPoints = 0;
+    for (std::size_t t = 0; t < n; ++t) nPoints += tracks.nPoints[t];
+    if (nPoints != e.nPoints) {
+        std::cerr << "[CompactEventFile] Event " << e.evtID << " has " << nPoints << " points, expected " << e.nPoints << std::endl;
+        return false;
+    }
+
+    // over the point cap, the points of the tracks left out are skipped, not stored
+    const std::vector<char> keep = SelectTracks(n, tracks.pid, tracks.kinE, tracks.nPoints, maxPoints);
+    data.evtID = e.evtID;
+    for (std::size_t t = 0; t < n; ++t) {
+        if (!keep[t]) {
+            ++data.nCappedTracks;
+            data.nCappedPoints += tracks.nPoints[t];
+            continue;
+        }
+        data.tid.push_back(tracks.tid[t]);
+        data.pid.push_back(tracks.pid[t]);
+        data.pdg.push_back(tracks.pdg[t]);
+        data.kinE.push_back(tracks.kinE[t]);
+        data.length.push_back(tracks.length[t]);
+        data.displacement.push_back(tracks.displacement[t]);
+        data.xmin.push_back(tracks.xmin[t]);
+        data.xmax.push_back(tracks.xmax[t]);
+        data.ymin.push_back(tracks.ymin[t]);
+        data.ymax.push_back(tracks.ymax[t]);
+        data.zmin.push_back(tracks.zmin[t]);
+        data.zmax.push_back(tracks.zmax[t]);
+        data.offsets.push_back(data.offsets.back() + tracks.nPoints[t]);
+    }
+
+    const std::size_t nKept = data.offsets.back();
+    data.x.resize(nKept);
+    data.y.resize(nKept);
+    data.z.resize(nKept);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(base_ + e.offset + ColumnBytes(n));
+    const unsigned char* end = reinterpret_cast<const unsigned char*>(base_ + e.offset + e.bytes);
+    const double quantum = quantum_;
+    uint32_t k = 0; // next kept point
+    for (std::size_t t = 0; t < n; ++t) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+
+        // each track starts from the origin: its first point is absolute
+        int64_t qx = 0, qy = 0, qz = 0;
+        for (uint32_t j = 0; j < tracks.nPoints[t]; ++j) {
+            uint64_t dx, dy, dz;
+            if (!GetVarint(p, end, dx) || !GetVarint(p, end, dy) || !GetVarint(p, end, dz)) {
+                std::cerr << "[CompactEventFile] Truncated points in event " << e.evtID << std::endl;
+                return false;
+            }
+            if (!keep[t]) continue;
+            qx += UnZigZag(dx);
+            qy += UnZigZag(dy);
+            qz += UnZigZag(dz);
+            data.x[k] = qx * quantum;
+            data.y[k] = qy * quantum;
+            data.z[k] = qz * quantum;
+            ++k;
+        }
+    }
+
+    // significances of the inner points, the end points are always kept
+    data.significance.resize(nKept);
+    k = 0;
+    for (std::size_t t = 0; t < n; ++t) {
+        const uint32_t size = tracks.nPoints[t];
+        if (size == 0) continue;
+        if (keep[t]) {
+            data.significance[k] = FLT_MAX;
+            data.significance[k + size - 1] = FLT_MAX;
+        }
+        for (uint32_t j = 1; j + 1 < size; ++j) {
+            uint64_t q;
+            if (!GetVarint(p, end, q)) {
+                std::cerr << "[CompactEventFile] Truncated significances in event " << e.evtID << std::endl;
+                return false;
+            }
+            if (keep[t]) data.significance[k + j] = q * quantum;
+        }
+        if (keep[t]) k += size;
+    }
+    return true;
+}
+
+CompactEventWriter::~CompactEventWriter()
+{
+    // not closed: the file is incomplete
+    Discard();
+}
+
+bool CompactEventWriter::Open(const std::string& filename, double quantum)
+{
+    Discard();
+    filename_ = filename;
+    tmpFilename_ = filename + ".tmp" + std::to_string(getpid());
+    quantum_ = quantum;
+    table_.clear();
+
+    out_.open(tmpFilename_, std::ios::binary | std::ios::trunc);
+    if (!out_ || quantum <= 0) {
+        std::cerr << "[CompactEventWriter] Could not create " << tmpFilename_ << std::endl;
+        Discard();
+        return false;
+    }
+
+    // the header is written again with the table offset by Close()
+    Header header{};
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    offset_ = sizeof(header);
+    return bool(out_);
+}
+
+double CompactEventWriter::AddEvent(const EventData& data)
+{
+    if (!out_.is_open()) return -1;
+
+    const std::size_t n = data.NTracks();
+    if (data.length.size() != n || data.significance.size() != data.NPoints()) {
+        std::cerr << "[CompactEventWriter] Event " << data.evtID << " has no track quantities or significances" << std::endl;
+        return -1;
+    }
+
+    block_.resize(ColumnBytes(n));
+    unsigned char* p = block_.data();
+    auto put = [p, n](int c, std::size_t t, const void* v) { std::memcpy(p + 4 * (n * c + t), v, 4); };
+    for (std::size_t t = 0; t < n; ++t) {
+        const int32_t tid = data.tid[t], pid = data.pid[t], pdg = data.pdg[t];
+        const uint32_t nPoints = data.Size(t);
+        put(kTID, t, &tid);
+        put(kPID, t, &pid);
+        put(kPDG, t, &pdg);
+        put(kKinE, t, &data.kinE[t]);
+        put(kNPoints, t, &nPoints);
+        put(kLength, t, &data.length[t]);
+        put(kDisplacement, t, &data.displacement[t]);
+        put(kXMin, t, &data.xmin[t]);
+        put(kXMax, t, &data.xmax[t]);
+        put(kYMin, t, &data.ymin[t]);
+        put(kYMax, t, &data.ymax[t]);
+        put(kZMin, t, &data.zmin[t]);
+        put(kZMax, t, &data.zmax[t]);
+    }
+
+    double maxError = 0;
+    auto quantize = [&](float v) {
+        const int64_t q = std::llround(v / quantum_);
+        maxError = std::max(maxError, std::fabs(q * quantum_ - v));
+        return q;
+    };
+    for (std::size_t t = 0; t < n; ++t) {
+        int64_t qx = 0, qy = 0, qz = 0;
+        for (uint32_t k = data.Begin(t); k < data.End(t); ++k) {
+            const int64_t x = quantize(data.x[k]), y = quantize(data.y[k]), z = quantize(data.z[k]);
+            PutVarint(block_, ZigZag(x - qx));
+            PutVarint(block_, ZigZag(y - qy));
+            PutVarint(block_, ZigZag(z - qz));
+            qx = x;
+            qy = y;
+            qz = z;
+        }
+    }
+    for (std::size_t t = 0; t < n; ++t) {
+        for (uint32_t k = data.Begin(t) + 1; k + 1 < data.End(t); ++k)
+            PutVarint(block_, std::llround(data.significance[k] / quantum_));
+    }
+
+    // blocks stay 8-byte aligned for the column arrays
+    const uint64_t bytes = block_.size();
+    block_.resize((block_.size() + 7) & ~std::size_t(7), 0);
+    out_.write(reinterpret_cast<const char*>(block_.data()), block_.size());
+    if (!out_) {
+        std::cerr << "[CompactEventWriter] Could not write event " << data.evtID << " to " << filename_ << std::endl;
+        return -1;
+    }
+
+    table_.push_back({data.evtID, uint32_t(n), uint64_t(data.NPoints()), offset_, bytes});
+    offset_ += block_.size();
+    return maxError;
+}
+
+bool CompactEventWriter::Close()
+{
+    if (!out_.is_open()) return false;
+
+    std::sort(table_.begin(), table_.end(),
+              [](const CompactEventFile::Event& a, const CompactEventFile::Event& b) { return a.evtID < b.evtID; });
+    out_.write(reinterpret_cast<const char*>(table_.data()), table_.size() * sizeof(CompactEventFile::Event));
+
+    Header header{};
+    std::memcpy(header.magic, kCompactMagic, sizeof(kCompactMagic));
+    header.version = kCompactVersion;
+    header.eventSize = sizeof(CompactEventFile::Event);
+    header.quantum = quantum_;
+    header.nEvents = table_.size();
+    header.tableOffset = offset_;
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    offset_ += table_.size() * sizeof(CompactEventFile::Event);
+    out_.close();
+    if (!out_ || std::rename(tmpFilename_.c_str(), filename_.c_str()) != 0) {
+        std::cerr << "[CompactEventWriter] Could not write " << filename_ << std::endl;
+        std::remove(tmpFilename_.c_str());
+        return false;
+    }
+    return true;
+}
+
+void CompactEventWriter::Discard()
+{
+    if (!out_.is_open()) return;
+    out_.close();
+    std::remove(tmpFilename_.c_str());
+}
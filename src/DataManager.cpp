@@ -1,240 +1,641 @@
 #include "DataManager.hh"
 
+#include <chrono>
 #include <iostream>
 #include <vector>
 #include <algorithm>
 #include <string>
 #include <sstream>
+#include <iomanip>
 
 #include "TFile.h"
+#include "TROOT.h"
 #include "TTree.h"
-#include "TTreeReaderValue.h"
-#include "TTreeReaderArray.h"
 #include "TEveElement.h"
-#include "TEvePointSet.h"
-#include "TEveLine.h"
 #include "TEveViewer.h"
 #include "TEveManager.h"
+#include "TSystem.h"
+
+#include "EventQuery.hh"
+#include "StageTimer.hh"
 
 DataManager::DataManager()
-    : currentEvent_(0),
+    : current_{0, 0},
       currentIndex_(0),
-      eventList_{currentEvent_},
-      rootFile_(nullptr),
-      trackList_(nullptr) {}
+      eventList_{current_},
+      trackList_(nullptr),
+      trackBatch_(nullptr) {}
 
 DataManager::~DataManager()
 {
-    if(rootFile_) rootFile_->Close();
+    StopSearch();
+    cache_.Stop();
 }
 
-bool DataManager::LoadFile(const std::string& filename)
+bool DataManager::LoadFiles(const std::vector<std::string>& patterns)
 {
-    std::cout << "[DataManager] Loading ROOT file: " << filename << std::endl;
+    StopSearch();
+    cache_.Stop();
+    cache_.Clear();
+    currentData_.reset();
 
-    if(rootFile_) {
-        rootFile_->Close();
-        rootFile_ = nullptr;
+    chain_.SetFiles(patterns);
+    if (chain_.NFiles() == 1) {
+        std::cout << "[DataManager] Loading ROOT file: " << chain_.GetFileName(0) << std::endl;
+    } else {
+        std::cout << "[DataManager] Chaining " << chain_.NFiles() << " ROOT files" << std::endl;
     }
 
-    rootFile_ = TFile::Open(filename.c_str(),"READ");
-    if( !rootFile_ || rootFile_->IsZombie() ){
-        std::cerr << "[DataManager] Error opening file " << filename << std::endl;
-        return false;
-    }
+    // files with a sidecar index are listed without being opened,
+    // the others when navigation reaches them
+    const int nIndexed = chain_.LoadSidecars();
+    if (chain_.NFiles() > 1)
+        std::cout << "[DataManager] " << nIndexed << " of " << chain_.NFiles() << " files already indexed" << std::endl;
+
+    fileEvents_.clear();
+    eventList_.clear();
+    nListed_ = 0;
+    query_.clear();
+    summaryRows_.clear();
+    summaryFiles_.clear();
 
-    std::string treeName = "trk";
-    trajReader_.SetTree(treeName.c_str(), rootFile_); 
-    if (!trajReader_.GetTree() ) {
-        std::cerr << "[DataManager] Could not find '" << treeName << "' tree "<< std::endl;
+    if (!ListNextFile()) {
+        std::cerr << "[DataManager] No events found in 'trk' tree" << std::endl;
+        chain_.Close();
+        eventList_ = {current_};
         return false;
     }
+    while (!AllFilesListed() && chain_.IsIndexed(nListed_)) ListNextFile();
 
-    // prepare event list
-    TTreeReaderValue<int> evtID_(trajReader_,"evtID");
-    eventList_.clear();
-    while (trajReader_.Next()) {
-        if (std::find(eventList_.begin(),eventList_.end(), *evtID_) == eventList_.end())
-            eventList_.push_back(*evtID_);
+    if (AllFilesListed()) {
+        std::cout << "[DataManager] There are " << eventList_.size() << " events in the tree" << std::endl;
+    } else {
+        std::cout << "[DataManager] There are " << eventList_.size() << " events in the first "
+                  << nListed_ << " files, the others are indexed when reached" << std::endl;
     }
-    std::sort(eventList_.begin(),eventList_.end());
-    trajReader_.Restart();
-
-    std::cout << "[DataManager] There are " << eventList_.size() << " events in the tree" << std::endl;
     currentIndex_ = 0;
-    currentEvent_ = eventList_.at(currentIndex_);
+    current_ = eventList_.at(currentIndex_);
+
+    cache_.Start(chain_.GetFileNames());
 
     return true;
 }
 
+bool DataManager::ListNextFile()
+{
+    while (!AllFilesListed()) {
+        const int file = nListed_++;
+        const EventIndex* index = chain_.GetIndex(file);
+        if (!index) {
+            std::cerr << "[DataManager] Skipping " << chain_.GetFileName(file) << std::endl;
+            continue;
+        }
+
+        const std::size_t first = fileEvents_.size();
+        for (int evtID : index->GetEventIDs()) fileEvents_.push_back({file, evtID});
+        if (query_.empty()) eventList_.insert(eventList_.end(), fileEvents_.begin() + first, fileEvents_.end());
+        return true;
+    }
+    return false;
+}
+
+std::vector<int> DataManager::ReadEventList(const std::string& filename)
+{
+    EventChain chain;
+    chain.SetFiles({filename});
+    const EventIndex* index = chain.GetIndex(0);
+    return index ? index->GetEventIDs() : std::vector<int>();
+}
+
 bool DataManager::NextEvent()
 {
-    if(!rootFile_) return false;
-    if (currentIndex_+1 >= eventList_.size()) {
+    if (!HasData()) return false;
+    if (currentIndex_+1 >= (int) eventList_.size() && !(query_.empty() && ListNextFile())) {
         std::cout << "[DataManager] Already at last event." << std::endl;
         return false;
     }
 
     ++currentIndex_;
-    currentEvent_ = eventList_.at(currentIndex_);
+    current_ = eventList_.at(currentIndex_);
     return true;
 }
 
 bool DataManager::PrevEvent()
 {
-    if(!rootFile_) return false;
+    if (!HasData()) return false;
     if (currentIndex_-1 < 0) {
         std::cout << "[DataManager] Already at first event." << std::endl;
         return false;
     }
     
     --currentIndex_;
-    currentEvent_ = eventList_.at(currentIndex_);
+    current_ = eventList_.at(currentIndex_);
     return true;
 }
 
-bool DataManager::LoadEvent()
+bool DataManager::GoToEvent(int evtID)
+{
+    if (!HasData()) return false;
+
+    // evtIDs restart in each file of a production: the current file first.
+    // Only the files indexed already are searched, indexing the others
+    // would open them: that is left to SearchAllFiles()
+    EventRef ref{current_.file, evtID};
+    if (!chain_.Find(ref)) {
+        ref.file = -1;
+        for (int f = 0; f < (int) chain_.NFiles() && ref.file < 0; ++f) {
+            if (f != current_.file && chain_.IsIndexed(f) && chain_.Find({f, evtID})) ref.file = f;
+        }
+    }
+    if (ref.file < 0) {
+        const int nUnindexed = CountUnindexed();
+        std::cerr << "[DataManager] No event " << evtID << " in the indexed data files";
+        if (nUnindexed > 0) std::cerr << ", " << nUnindexed << " files not indexed yet: search all files to index them";
+        std::cerr << std::endl;
+        return false;
+    }
+    return GoToEvent(ref);
+}
+
+int DataManager::CountUnindexed() const
+{
+    int n = 0;
+    for (int f = 0; f < (int) chain_.NFiles(); ++f) n += !chain_.IsIndexed(f) && !chain_.IsFailed(f);
+    return n;
+}
+
+bool DataManager::SearchAllFiles(int evtID)
+{
+    StopSearch();
+    if (!HasData()) return false;
+
+    // in chain order: once found, the files before it are indexed too,
+    // so that listing them up to it does not open any
+    std::vector<std::pair<int, std::string>> todo;
+    for (int f = 0; f < (int) chain_.NFiles(); ++f) {
+        if (!chain_.IsIndexed(f) && !chain_.IsFailed(f)) todo.push_back({f, chain_.GetFileName(f)});
+    }
+    if (todo.empty()) {
+        std::cerr << "[DataManager] All data files are indexed, no event " << evtID << " in them" << std::endl;
+        return false;
+    }
+
+    std::cout << "[DataManager] Indexing " << todo.size() << " data files to find event " << evtID << std::endl;
+    ROOT::EnableThreadSafety();
+    searchID_ = evtID;
+    searchStop_ = false;
+    searchDone_ = false;
+    searching_ = true;
+    searcher_ = std::thread([this, evtID, todo]() {
+        for (const auto& file : todo) {
+            if (searchStop_) break;
+            EventIndex index;
+            bool ok = EventChain::LoadIndex(file.second, index);
+            if (!ok) {
+                EventReader reader;
+                ok = reader.Open(file.second) && EventChain::BuildIndex(file.second, reader, index);
+            }
+            if (!ok) continue; // the GUI thread tries again if it reaches the file
+            const bool found = index.Find(evtID) != nullptr;
+            {
+                std::lock_guard<std::mutex> lock(searchMutex_);
+                searchIndexed_.emplace_back(file.first, std::move(index));
+            }
+            if (found) break;
+        }
+        searchDone_ = true;
+    });
+    return true;
+}
+
+bool DataManager::PollSearch()
+{
+    if (!searching_) return false;
+
+    // the indexes built so far are kept, whatever the outcome
+    const bool done = searchDone_;
+    std::vector<std::pair<int, EventIndex>> indexed;
+    {
+        std::lock_guard<std::mutex> lock(searchMutex_);
+        indexed.swap(searchIndexed_);
+    }
+    for (auto& it : indexed) chain_.SetIndex(it.first, std::move(it.second));
+
+    for (const auto& it : indexed) {
+        const EventRef ref{it.first, searchID_};
+        if (chain_.Find(ref)) {
+            StopSearch();
+            return GoToEvent(ref);
+        }
+    }
+    if (done) {
+        std::cerr << "[DataManager] No event " << searchID_ << " in any of the data files" << std::endl;
+        StopSearch();
+    }
+    return false;
+}
+
+void DataManager::StopSearch()
+{
+    if (!searching_) return;
+    searchStop_ = true;
+    if (searcher_.joinable()) searcher_.join();
+    searching_ = false;
+
+    // indexes finished meanwhile are not wasted
+    std::lock_guard<std::mutex> lock(searchMutex_);
+    for (auto& it : searchIndexed_) chain_.SetIndex(it.first, std::move(it.second));
+    searchIndexed_.clear();
+}
+
+bool DataManager::GoToEvent(const EventRef& ref)
 {
-    if(!rootFile_){
+    if (!HasData()) return false;
+
+    // binary search in the index of the file
+    if (!chain_.Find(ref)) {
+        std::cerr << "[DataManager] No event " << ref.evtID << " in " << chain_.GetFileName(ref.file) << std::endl;
+        return false;
+    }
+    while (nListed_ <= ref.file && ListNextFile()) {}
+
+    // a query may have reordered the navigable events
+    auto it = query_.empty() ? std::lower_bound(eventList_.begin(), eventList_.end(), ref)
+                             : std::find(eventList_.begin(), eventList_.end(), ref);
+    if (it == eventList_.end() || *it != ref) {
+        std::cout << "[DataManager] Event " << ref.evtID << " is not selected by '" << query_ << "', navigating all events again" << std::endl;
+        query_.clear();
+        eventList_ = fileEvents_;
+        it = std::lower_bound(eventList_.begin(), eventList_.end(), ref);
+    }
+
+    currentIndex_ = it - eventList_.begin();
+    current_ = ref;
+    return true;
+}
+
+bool DataManager::SetQuery(const std::string& query, std::string& error)
+{
+    error.clear();
+    if (!HasData()) {
+        error = "No data file";
+        return false;
+    }
+
+    EventQuery parsed;
+    if (!parsed.Parse(query, error)) {
+        std::cerr << "[DataManager] Invalid query '" << query << "': " << error << std::endl;
+        return false;
+    }
+
+    std::vector<EventRef> selected;
+    if (parsed.HasFilter() || parsed.HasSort()) {
+        if (!LoadSummaries()) {
+            error = "Could not summarize the events";
+            return false;
+        }
+        StageTimer timer("event.query");
+        std::vector<std::size_t> rows = parsed.Select(summaryRows_);
+        selected.reserve(rows.size());
+        for (std::size_t i : rows) selected.push_back({summaryFiles_[i], summaryRows_[i].evtID});
+    } else {
+        selected = fileEvents_;
+    }
+    if (selected.empty()) {
+        error = "No event selected";
+        std::cout << "[DataManager] No event selected by '" << query << "', keeping the current selection" << std::endl;
+        return false;
+    }
+
+    query_ = (parsed.HasFilter() || parsed.HasSort()) ? query : "";
+    eventList_.swap(selected);
+    std::cout << "[DataManager] " << eventList_.size() << " of " << GetNEvents() << " events selected" << std::endl;
+
+    // stay on the current event if still selected, otherwise start from the first one
+    auto it = std::find(eventList_.begin(), eventList_.end(), current_);
+    currentIndex_ = it != eventList_.end() ? it - eventList_.begin() : 0;
+    current_ = eventList_[currentIndex_];
+    return true;
+}
+
+bool DataManager::LoadSummaries()
+{
+    if (!summaryRows_.empty()) return true;
+
+    // computed once per file, in parallel, then kept next to the event index;
+    // the sidecar is found without opening the file
+    StageTimer timer("event.summary");
+    for (int f = 0; f < (int) chain_.NFiles(); ++f) {
+        const std::string& filename = chain_.GetFileName(f);
+        EventIndex::Key key = EventIndex::MakeKey(filename);
+        std::string sidecar = EventSummary::SidecarPath(key);
+
+        EventSummary summary;
+        if (summary.Load(sidecar, key)) {
+            std::cout << "[DataManager] Using event summary " << sidecar << std::endl;
+        } else if (summary.Build(filename)) {
+            if (summary.Save(sidecar, key))
+                std::cout << "[DataManager] Saved event summary to " << sidecar << std::endl;
+        } else {
+            continue;
+        }
+        summaryRows_.insert(summaryRows_.end(), summary.GetRows().begin(), summary.GetRows().end());
+        summaryFiles_.insert(summaryFiles_.end(), summary.Size(), f);
+    }
+    return !summaryRows_.empty();
+}
+
+const EventIndex::Entry* DataManager::FindCurrent()
+{
+    if (!HasData()) {
         std::cout << "[DataManager] No data file selected, skipping event loading" << std::endl;
+        return nullptr;
+    }
+
+    const EventIndex::Entry* range = chain_.Find(current_);
+    if (!range) {
+        std::cerr << "[DataManager] Event out of range: " << current_.evtID << "(index " << currentIndex_ << ")" << std::endl;
+        return nullptr;
+    }
+
+    std::cout << "[DataManager] Loading event " << current_.evtID;
+    if (chain_.NFiles() > 1) std::cout << " of " << chain_.GetFileName(current_.file);
+    std::cout << std::endl;
+    return range;
+}
+
+bool DataManager::LoadEvent()
+{
+    loading_ = false;
+    if (!FindCurrent()) return false;
+
+    // decoded tracks come from the prefetch cache if possible
+    StageTimer readTimer("event.read", current_.evtID);
+    std::shared_ptr<const EventData> data = cache_.Get(current_);
+    if (!data) {
+        auto decoded = std::make_shared<EventData>();
+        if (!chain_.ReadEvent(current_, *decoded))
+            return false;
+        cache_.Put(decoded);
+        data = decoded;
+    }
+    readTimer.Stop();
+    BuildEvent(data);
+    return true;
+}
+
+bool DataManager::RequestEvent()
+{
+    if (!cache_.IsRunning()) return LoadEvent();
+
+    const EventIndex::Entry* range = FindCurrent();
+    if (!range) {
+        loading_ = false;
         return false;
     }
 
-    if (std::find(eventList_.begin(),eventList_.end(), currentEvent_) == eventList_.end()) {
-        std::cerr << "[DataManager] Event out of range: " << currentEvent_ << "(index " << currentIndex_ << ")" << std::endl;
+    // a request still pending for another event is superseded
+    cache_.Load({current_.file, *range});
+    loading_ = true;
+    loadStart_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool DataManager::PollEvent()
+{
+    std::shared_ptr<const EventData> data;
+    if (!loading_ || !cache_.TakeLoaded(current_, data)) return false;
+
+    loading_ = false;
+    StageStats::Instance().Record("event.read",
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart_).count(), current_.evtID);
+    if (!data) {
+        std::cerr << "[DataManager] Could not read event " << current_.evtID << std::endl;
         return false;
     }
+    BuildEvent(data);
+    return true;
+}
+
+void DataManager::BuildEvent(const std::shared_ptr<const EventData>& data)
+{
+    currentData_ = data;
+    RequestPrefetch();
     
-    std::cout << "[DataManager] Loading event " << currentEvent_ << std::endl;
-    
-    // Clear previous tracks
-    if (trackList_) {
-        trackList_->DestroyElements();
-    } else {
-        // Create track container
+    // Create track container and the batch holding all its tracks
+    StageTimer buildTimer("event.build", current_.evtID);
+    if (!trackList_) {
         trackList_ = new TEveElementList("Tracks");
+        trackBatch_ = new TrackBatch("Tracks");
+        trackList_->AddElement(trackBatch_);
         gEve->AddElement(trackList_);
     }
 
-    TTreeReaderValue<int> evtID_(trajReader_,"evtID");
-    TTreeReaderValue<int> trackTID_(trajReader_,"trackTID");
-    TTreeReaderValue<int> trackPID_(trajReader_,"trackPID");
-    TTreeReaderValue<int> trackPDG_(trajReader_,"trackPDG");
-    TTreeReaderValue<double> trackKinE_(trajReader_,"trackKinE");
-    TTreeReaderValue<int> trackNPoints_(trajReader_,"trackNPoints");
-    TTreeReaderArray<double> trackPointX_(trajReader_,"trackPointX");
-    TTreeReaderArray<double> trackPointY_(trajReader_,"trackPointY");
-    TTreeReaderArray<double> trackPointZ_(trajReader_,"trackPointZ");
-
+    // the tracks go in the batch, the cuts only hide them
     std::cout << "[DataManager] Selecting tracks longer than " << lengthCut_ << " cm and above " << kinECut_ << " MeV initial kinetic energy" << std::endl;
+    StartBuild();
+    buildTimer.Stop();
 
-    while( trajReader_.Next()){
+    std::cout << "[DataManager] Switched to event " << current_.evtID << " (" << trackBatch_->GetNVisible() << " of " << trackBatch_->GetNTracks() << " tracks shown";
+    if (!IsEventComplete()) std::cout << ", " << pending_.size() - nextPending_ << " more to build";
+    if (nOmittedTracks_ > 0) std::cout << ", " << nOmittedTracks_ << " omitted by the vertex cap";
+    std::cout << ")" << std::endl;
+    std::cout << "[DataManager] " << GetLODSummary() << std::endl;
+    std::cout << "[DataManager] " << GetIOSummary() << std::endl;
+}
 
-        //select event
-        if( *evtID_ != currentEvent_ ) continue; 
+void DataManager::StartBuild()
+{
+    const EventData& data = *currentData_;
 
-        const int npts = *trackNPoints_;
-        const double mm_to_cm = 1e-1;
+    // primaries first, then the secondaries passing the cuts, then the
+    // others (hidden, but there at once if the cuts are loosened);
+    // by decreasing energy within each
+    std::vector<uint32_t> order(data.NTracks());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    auto rank = [&](uint32_t t) { return data.pid[t] == 0 ? 0 : PassesCuts(t) ? 1 : 2; };
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        const int ra = rank(a), rb = rank(b);
+        return ra != rb ? ra < rb : data.kinE[a] > data.kinE[b];
+    });
 
-        // to avoid rendering too many segments, skip track if
-        // - it's not a primary track AND
-        // - it's below min kinE threshold OR
-        // - it's below min length threshold
-        if( *trackPID_ != 0 ){ //primary tracks have no parents :(
+    // the vertex cap bounds the batch, its levels of detail and projections
+    pending_.clear();
+    nextPending_ = 0;
+    // counting the tracks left out when reading, which did not know the cuts
+    nOmittedTracks_ = data.nCappedTracks;
+    nOmittedVertices_ = data.nCappedPoints;
+    Long64_t nVertices = 0;
+    for (uint32_t t : order) {
+        const Long64_t n = data.Size(t);
+        if (maxVertices_ > 0 && nVertices + n > maxVertices_) {
+            ++nOmittedTracks_;
+            nOmittedVertices_ += n;
+            continue;
+        }
+        nVertices += n;
+        pending_.push_back(t);
+    }
 
-            double dx = trackPointX_[npts-1] - trackPointX_[0];
-	        double dy = trackPointY_[npts-1] - trackPointY_[0];
-	        double dz = trackPointZ_[npts-1] - trackPointZ_[0];
-	        double len = TMath::Sqrt(dx*dx + dy*dy + dz*dz)*mm_to_cm;
+    trackBatch_->SetTracks(currentData_, NextChunk());
+    ApplyCuts();
+}
 
-            // if you are not a primary, apply kinetic energy cut
-            // this helps to avoid rendering too many segments
-            if ( *trackKinE_ < kinECut_ || len < lengthCut_ )
-                continue; 
-        }
-    
-        // Create the track and add it to the list   
-        TEveLine* track = new TEveLine(Form("Track %d", *trackTID_), npts);
-        track->SetSmooth(kTRUE);
+std::vector<uint32_t> DataManager::NextChunk()
+{
+    // the first chunk takes all primaries, whatever their size
+    const bool first = nextPending_ == 0;
+    std::vector<uint32_t> chunk;
+    Long64_t nVertices = 0;
+    while (nextPending_ < pending_.size()) {
+        const uint32_t t = pending_[nextPending_];
+        const Long64_t n = currentData_->Size(t);
+        const bool primary = currentData_->pid[t] == 0;
+        if (chunkVertices_ > 0 && !chunk.empty() && nVertices + n > chunkVertices_ && !(first && primary))
+            break;
+        chunk.push_back(t);
+        nVertices += n;
+        ++nextPending_;
+    }
+    return chunk;
+}
 
-        SetTrackStylebyPDG(track, *trackPDG_);
+bool DataManager::BuildNextChunk()
+{
+    if (!trackBatch_ || !currentData_ || IsEventComplete()) return false;
 
-        for (int k = 0; k < npts; ++k) {
-            track->SetNextPoint(trackPointX_[k]*mm_to_cm,trackPointY_[k]*mm_to_cm,trackPointZ_[k]*mm_to_cm);
-        }
-        
-        trackList_->AddElement(track);
+    StageTimer timer("event.chunk", current_.evtID);
+    trackBatch_->AddTracks(NextChunk());
+    ApplyCuts();
+    return true;
+}
+
+void DataManager::SetMaxVertices(Long64_t vertices)
+{
+    // the readers apply it first, so that the decoded events are bounded too
+    maxVertices_ = vertices;
+    chain_.SetMaxPoints(vertices);
+    cache_.SetMaxPoints(vertices);
+}
+
+bool DataManager::SetCuts(double kinECut, double lengthCut)
+{
+    kinECut_ = kinECut;
+    lengthCut_ = lengthCut;
+    std::cout << "[DataManager] Selecting tracks longer than " << lengthCut_ << " cm and above " << kinECut_ << " MeV initial kinetic energy" << std::endl;
+
+    // the cuts decide which tracks the vertex cap keeps, among those
+    // decoded: the tracks left out when reading cannot come back
+    if (currentData_ && trackBatch_ && nOmittedTracks_ > currentData_->nCappedTracks) {
+        StartBuild();
+        return true;
     }
+    return ApplyCuts() > 0;
+}
 
-    trajReader_.Restart();
-    
-    std::cout << "[DataManager] Switched to event " << currentEvent_ << " (" << trackList_->NumChildren() << " tracks)" << std::endl;
+bool DataManager::PassesCuts(std::size_t i) const
+{
+    const EventData& data = *currentData_;
+
+    // to avoid rendering too many segments, skip track if
+    // - it's not a primary track AND
+    // - it's below min kinE threshold OR
+    // - it's below min length threshold
+    if( data.pid[i] != 0 ){ //primary tracks have no parents :(
+
+        // if you are not a primary, apply kinetic energy cut
+        // this helps to avoid rendering too many segments.
+        // The length is the one along the trajectory, so that
+        // tracks curling in a magnetic field are not cut away
+        if ( data.kinE[i] < kinECut_ || data.length[i] < lengthCut_ )
+            return false;
+    }
     return true;
 }
 
-void DataManager::SetTrackStylebyPDG(TEveLine* track, int pdg)
+int DataManager::ApplyCuts()
 {
-    switch(pdg){
-        // gamma
-        case 22:
-            track->SetLineStyle(10);
-            track->SetLineColor(kGray);
-            track->SetLineWidth(1);
-            break;
-        
-        // e+/e-
-        case 11:
-        case -11:
-            track->SetLineColor(kRed);
-            break;
-  
-        // mu+/mu-
-        case 13:
-        case -13:
-            track->SetLineColor(kBlue+1);
-            track->SetLineWidth(1);
-            break;
-  
-        // proton
-        case 2212:
-            track->SetLineColor(kBlack);
-            track->SetLineWidth(1);
-            break;
-  
-        // neutron
-        case 2112:
-            track->SetLineStyle(7);
-            track->SetLineColor(kOrange);
-            track->SetLineWidth(1);
-            break;
-  
-        // pion0
-        case 111:
-            track->SetLineStyle(7);
-            track->SetLineColor(kMagenta);
-            break;
-  
-        // pion+/pion-
-        case 211:
-        case -211:;
-            track->SetLineColor(kCyan);
-            track->SetLineColor(kCyan);
-            break;
-  
-        default:
-            track->SetLineColor(8);
-            track->SetLineWidth(1);
-            break;
+    if (!currentData_ || !trackBatch_) return 0;
+    const EventData& data = *currentData_;
+
+    std::vector<UChar_t> visible(data.NTracks());
+    for (std::size_t i = 0; i < data.NTracks(); ++i) visible[i] = PassesCuts(i);
+
+    return trackBatch_->SetVisibility(visible);
+}
+
+void DataManager::RequestPrefetch()
+{
+    // shifters mostly step forward: queue the next events first.
+    // Files not indexed yet are left to the navigation
+    std::vector<EventCache::Request> todo;
+    auto request = [&](int i) {
+        const EventRef& ref = eventList_[i];
+        if (!chain_.IsIndexed(ref.file)) return;
+        if (const EventIndex::Entry* range = chain_.Find(ref)) todo.push_back({ref.file, *range});
+    };
+    const int nEvents = eventList_.size();
+    for (int d = 1; d <= prefetchDepth_; ++d) {
+        if (currentIndex_+d < nEvents) request(currentIndex_+d);
     }
+    for (int d = 1; d <= prefetchDepth_; ++d) {
+        if (currentIndex_-d >= 0) request(currentIndex_-d);
+    }
+    cache_.Prefetch(todo);
+}
+
+std::string DataManager::GetLODSummary() const
+{
+    std::stringstream ss;
+    if (!trackBatch_ || trackBatch_->GetNLevels() == 0) return ss.str();
+
+    const int full = trackBatch_->GetNVertices(0);
+    ss << "Vertices: " << full;
+    for (int l = 1; l < trackBatch_->GetNLevels(); ++l) {
+        ss << (l == 1 ? " (LOD " : ", ")
+           << trackBatch_->GetLevel(l).tolerance << " cm: "
+           << std::fixed << std::setprecision(1) << (full ? 100. * trackBatch_->GetNVertices(l) / full : 0.) << "%"
+           << std::defaultfloat;
+        if (l == trackBatch_->GetNLevels() - 1) ss << ")";
+    }
+    return ss.str();
+}
+
+std::string DataManager::GetIOSummary() const
+{
+    std::stringstream ss;
+    if (!currentData_) return ss.str();
+
+    // as read by whichever thread decoded the event, prefetched or not
+    ss << "I/O: " << std::fixed << std::setprecision(1) << currentData_->bytesRead / 1024. << " kB in "
+       << currentData_->readCalls << " reads";
+    if (currentData_->unzipMs >= 0) ss << ", " << currentData_->unzipMs << " ms decompressing";
+    ss << std::defaultfloat;
+    return ss.str();
 }
 
 std::string DataManager::GetSummary() const 
 {
     std::stringstream ss;
-    ss << "Event #" << currentEvent_;
-    ss << " (" << currentIndex_+1 << " of " << eventList_.size() << ") loaded";
-    ss << "\n\nTrack count: " << (trackList_ ? trackList_->NumChildren() : 0);
+    ss << "Event #" << current_.evtID;
+    ss << " (" << currentIndex_+1 << " of " << eventList_.size() << (query_.empty() && !AllFilesListed() ? "+" : "") << ")";
+    ss << (loading_ ? " loading..." : " loaded");
+    if (chain_.NFiles() > 1) {
+        ss << "\nFile " << current_.file+1 << " of " << chain_.NFiles() << ": " << gSystem->BaseName(chain_.GetFileName(current_.file).c_str());
+        ss << " (" << chain_.GetNOpenFiles() << " open, at most " << chain_.GetMaxOpenFiles() << ")";
+    }
+    if (!query_.empty()) ss << "\nSelection: " << query_ << " (" << eventList_.size() << " of " << GetNEvents() << " events)";
+    ss << "\n\nTrack count: " << (trackBatch_ ? trackBatch_->GetNVisible() : 0);
+    ss << " (of " << (trackBatch_ ? trackBatch_->GetNTracks() : 0) << ")";
+    ss << "\n" << GetLODSummary();
+    ss << "\n" << GetIOSummary();
+    if (!IsEventComplete()) ss << "\nBuilding: " << nextPending_ << " of " << pending_.size() << " tracks";
+    if (nOmittedTracks_ > 0)
+        ss << "\nOmitted by the " << maxVertices_ << " vertex cap: " << nOmittedTracks_ << " tracks, " << nOmittedVertices_ << " vertices";
     ss << "\nKinetic energy threshold: " << kinECut_ << " MeV";
     ss << "\nLength threshold: " << lengthCut_ << " cm";
+    ss << "\n\nEvent cache: " << cache_.GetHits() << " hits, " << cache_.GetMisses() << " misses";
+    ss << " (" << (cache_.GetBytes() >> 20) << "/" << (cache_.GetCapacity() >> 20) << " MB)";
+    if (cache_.GetCancelled() > 0) ss << ", " << cache_.GetCancelled() << " superseded loads";
     return ss.str();
 }
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "EventCache.hh"
+
+#include "TROOT.h"
+
+#include "EventReader.hh"
+
+namespace {
+    const Long64_t kNoEvent = -1;
+}
+
+EventCache::EventCache()
+    : capacity_(256u << 20),
+      maxPoints_(0),
+      bytes_(0),
+      hits_(0),
+      misses_(0),
+      cancelled_(0),
+      inFlight_(kNoEvent),
+      stop_(false),
+      wanted_(kNoEvent),
+      wantedRequest_{0, {}},
+      wantedDone_(false),
+      cancel_(false) {}
+
+EventCache::~EventCache()
+{
+    Stop();
+}
+
+void EventCache::SetCapacity(std::size_t megabytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = megabytes << 20;
+
+    while (bytes_ > capacity_ && !lru_.empty()) {
+        auto it = slots_.find(lru_.back());
+        bytes_ -= it->second.data->Bytes();
+        slots_.erase(it);
+        lru_.pop_back();
+    }
+}
+
+void EventCache::Start(const std::vector<std::string>& filenames)
+{
+    Stop();
+    if (capacity_ == 0) return;
+
+    // the worker opens its own TFiles, ROOT needs to know
+    ROOT::EnableThreadSafety();
+
+    stop_ = false;
+    worker_ = std::thread(&EventCache::Run, this, filenames);
+}
+
+void EventCache::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        queue_.clear();
+        wanted_ = kNoEvent;
+        loaded_.reset();
+        cancel_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+void EventCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_.clear();
+    lru_.clear();
+    bytes_ = 0;
+    hits_ = 0;
+    misses_ = 0;
+    cancelled_ = 0;
+}
+
+std::shared_ptr<const EventData> EventCache::Get(const EventRef& ref)
+{
+    const SlotKey key = MakeSlotKey(ref.file, ref.evtID);
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // the worker is already decoding it: cheaper to wait than to start over
+    done_.wait(lock, [&] { return inFlight_ != key; });
+
+    auto it = slots_.find(key);
+    if (it == slots_.end()) {
+        ++misses_;
+        return nullptr;
+    }
+
+    ++hits_;
+    lru_.splice(lru_.begin(), lru_, it->second.pos);
+    return it->second.data;
+}
+
+void EventCache::Put(const std::shared_ptr<const EventData>& data)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Insert(data);
+}
+
+void EventCache::Prefetch(const std::vector<Request>& events)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!worker_.joinable()) return;
+        queue_.assign(events.begin(), events.end());
+
+        // the event to display stays first
+        if (wanted_ != kNoEvent && !wantedDone_ && inFlight_ != wanted_) queue_.push_front(wantedRequest_);
+    }
+    wake_.notify_one();
+}
+
+void EventCache::Load(const Request& event)
+{
+    const SlotKey key = MakeSlotKey(event.file, event.range.evtID);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wanted_ = key;
+        wantedRequest_ = event;
+        wantedDone_ = false;
+        loaded_.reset();
+
+        auto it = slots_.find(key);
+        if (it != slots_.end()) {
+            ++hits_;
+            lru_.splice(lru_.begin(), lru_, it->second.pos);
+            loaded_ = it->second.data;
+            wantedDone_ = true;
+            return;
+        }
+        ++misses_;
+
+        // whatever was queued or is being decoded for an older click is stale
+        queue_.assign(1, event);
+        if (inFlight_ != kNoEvent && inFlight_ != key) cancel_ = true;
+    }
+    wake_.notify_one();
+}
+
+bool EventCache::TakeLoaded(const EventRef& ref, std::shared_ptr<const EventData>& data)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (wanted_ != MakeSlotKey(ref.file, ref.evtID) || !wantedDone_) return false;
+
+    data = loaded_;
+    loaded_.reset();
+    wanted_ = kNoEvent;
+    return true;
+}
+
+std::size_t EventCache::GetBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+void EventCache::Insert(const std::shared_ptr<const EventData>& data)
+{
+    const SlotKey key = MakeSlotKey(data->file, data->evtID);
+    if (slots_.count(key)) return;
+
+    lru_.push_front(key);
+    slots_[key] = {data, lru_.begin()};
+    bytes_ += data->Bytes();
+
+    // an event bigger than the whole cache evicts itself
+    while (bytes_ > capacity_ && !lru_.empty()) {
+        auto it = slots_.find(lru_.back());
+        bytes_ -= it->second.data->Bytes();
+        slots_.erase(it);
+        lru_.pop_back();
+    }
+}
+
+void EventCache::Run(std::vector<std::string> filenames)
+{
+    // files are opened as requests reach them, the GUI thread has its own handles
+    EventChain chain;
+    chain.SetFiles(filenames);
+    chain.SetMaxOpenFiles(2);
+    chain.SetMaxPoints(maxPoints_);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+        if (stop_) break;
+
+        Request request = queue_.front();
+        queue_.pop_front();
+        const SlotKey key = MakeSlotKey(request.file, request.range.evtID);
+        auto it = slots_.find(key);
+        if (it != slots_.end()) {
+            if (key == wanted_ && !wantedDone_) {
+                loaded_ = it->second.data;
+                wantedDone_ = true;
+            }
+            continue;
+        }
+
+        inFlight_ = key;
+        cancel_ = false;
+        lock.unlock();
+
+        auto data = std::make_shared<EventData>();
+        EventReader* reader = chain.GetReader(request.file);
+        bool ok = reader && reader->ReadEvent(request.range, *data, &cancel_);
+        data->file = request.file;
+
+        lock.lock();
+        inFlight_ = kNoEvent;
+        if (ok) Insert(data);
+        else if (cancel_) ++cancelled_;
+        if (key == wanted_ && !wantedDone_ && !cancel_) {
+            loaded_ = ok ? data : nullptr;
+            wantedDone_ = true;
+        }
+        done_.notify_all();
+    }
+}
@@ -0,0 +1,187 @@
+#include "EventChain.hh"
+
+#include <algorithm>
+#include <glob.h>
+#include <iostream>
+
+#include "StageTimer.hh"
+
+std::vector<std::string> EventChain::Expand(const std::vector<std::string>& patterns)
+{
+    std::vector<std::string> files;
+    for (const std::string& pattern : patterns) {
+        if (pattern.find_first_of("*?[") == std::string::npos) {
+            files.push_back(pattern);
+            continue;
+        }
+
+        // glob() sorts its matches
+        glob_t matches;
+        if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+            for (std::size_t i = 0; i < matches.gl_pathc; ++i) files.push_back(matches.gl_pathv[i]);
+        } else {
+            std::cerr << "[EventChain] No file matches " << pattern << std::endl;
+            files.push_back(pattern);
+        }
+        globfree(&matches);
+    }
+    return files;
+}
+
+void EventChain::SetFiles(const std::vector<std::string>& patterns)
+{
+    Close();
+    files_.clear();
+    for (const std::string& name : Expand(patterns)) {
+        files_.emplace_back();
+        files_.back().name = name;
+    }
+}
+
+std::vector<std::string> EventChain::GetFileNames() const
+{
+    std::vector<std::string> names;
+    for (const File& f : files_) names.push_back(f.name);
+    return names;
+}
+
+void EventChain::SetMaxOpenFiles(int n)
+{
+    maxOpen_ = std::max(n, 1);
+    CloseUnused(-1);
+}
+
+void EventChain::SetMaxPoints(Long64_t points)
+{
+    maxPoints_ = points;
+    for (File& f : files_) {
+        if (f.reader) f.reader->SetMaxPoints(points);
+    }
+}
+
+int EventChain::LoadSidecars()
+{
+    int n = 0;
+    for (File& f : files_) {
+        if (!f.indexed) {
+            EventIndex::Key key = EventIndex::MakeKey(f.name);
+            f.indexed = f.index.Load(EventIndex::SidecarPath(key), key);
+        }
+        n += f.indexed;
+    }
+    return n;
+}
+
+const EventIndex* EventChain::GetIndex(int file)
+{
+    File& f = files_[file];
+    if (f.indexed) return &f.index;
+    if (f.failed) return nullptr;
+
+    // the file is only opened when it has no sidecar index
+    StageTimer timer("file.index");
+    if (LoadIndex(f.name, f.index)) {
+        f.indexed = true;
+        return &f.index;
+    }
+    EventReader* reader = GetReader(file);
+    if (!reader) return nullptr;
+    if (!BuildIndex(f.name, *reader, f.index)) {
+        f.failed = true;
+        return nullptr;
+    }
+    f.indexed = true;
+    return &f.index;
+}
+
+bool EventChain::LoadIndex(const std::string& name, EventIndex& index)
+{
+    // reuse the sidecar index if it was built for this very file
+    EventIndex::Key key = EventIndex::MakeKey(name);
+    std::string sidecar = EventIndex::SidecarPath(key);
+    if (!index.Load(sidecar, key)) return false;
+    std::cout << "[EventChain] Using event index " << sidecar << std::endl;
+    return true;
+}
+
+bool EventChain::BuildIndex(const std::string& name, EventReader& reader, EventIndex& index)
+{
+    // one pass over evtID mapping each event to its range of tree entries
+    if (!reader.BuildIndex(index)) {
+        std::cerr << "[EventChain] No events found in " << name << std::endl;
+        return false;
+    }
+    EventIndex::Key key = EventIndex::MakeKey(reader.GetFile(), name);
+    std::string sidecar = EventIndex::SidecarPath(key);
+    if (index.Save(sidecar, key))
+        std::cout << "[EventChain] Saved event index to " << sidecar << std::endl;
+    return true;
+}
+
+void EventChain::SetIndex(int file, EventIndex&& index)
+{
+    File& f = files_[file];
+    if (f.indexed) return;
+    f.index = std::move(index);
+    f.indexed = true;
+    f.failed = false;
+}
+
+const EventIndex::Entry* EventChain::Find(const EventRef& ref)
+{
+    if (ref.file < 0 || ref.file >= (int) files_.size()) return nullptr;
+    const EventIndex* index = GetIndex(ref.file);
+    return index ? index->Find(ref.evtID) : nullptr;
+}
+
+EventReader* EventChain::GetReader(int file)
+{
+    File& f = files_[file];
+    f.lastUse = ++useCounter_;
+    if (f.reader) return f.reader.get();
+    if (f.failed) return nullptr;
+
+    CloseUnused(file);
+
+    StageTimer timer("file.open");
+    std::unique_ptr<EventReader> reader(new EventReader());
+    reader->SetMaxPoints(maxPoints_);
+    if (!reader->Open(f.name)) {
+        f.failed = true;
+        return nullptr;
+    }
+    f.reader = std::move(reader);
+    ++nOpen_;
+    return f.reader.get();
+}
+
+bool EventChain::ReadEvent(const EventRef& ref, EventData& data)
+{
+    const EventIndex::Entry* range = Find(ref);
+    EventReader* reader = range ? GetReader(ref.file) : nullptr;
+    if (!reader || !reader->ReadEvent(*range, data)) return false;
+    data.file = ref.file;
+    return true;
+}
+
+void EventChain::Close()
+{
+    for (File& f : files_) f.reader.reset();
+    nOpen_ = 0;
+}
+
+void EventChain::CloseUnused(int keep)
+{
+    // room for one more file if `keep` is about to be opened
+    const int limit = (keep >= 0 && !files_[keep].reader) ? maxOpen_ - 1 : maxOpen_;
+    while (nOpen_ > limit) {
+        File* oldest = nullptr;
+        for (std::size_t i = 0; i < files_.size(); ++i) {
+            if ((int) i == keep || !files_[i].reader) continue;
+            if (!oldest || files_[i].lastUse < oldest->lastUse) oldest = &files_[i];
+        }
+        if (!oldest) break;
+        oldest->reader.reset();
+        --nOpen_;
+    }
+}
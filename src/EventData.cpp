@@ -0,0 +1,101 @@
+#include "EventData.hh"
+
+#include <algorithm>
+
+namespace {
+    // contiguous, non-aliased loop: auto-vectorized by the compiler
+    void ScaleToFloat(const double* __restrict in, float* __restrict out, std::size_t n, double scale)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = static_cast<float>(in[i] * scale);
+    }
+}
+
+void EventData::Clear()
+{
+    bytesRead = 0;
+    readCalls = 0;
+    unzipMs = -1;
+    nCappedTracks = 0;
+    nCappedPoints = 0;
+    x.clear();
+    y.clear();
+    z.clear();
+    offsets.assign(1, 0);
+    significance.clear();
+    tid.clear();
+    pid.clear();
+    pdg.clear();
+    kinE.clear();
+    length.clear();
+    displacement.clear();
+    xmin.clear(); xmax.clear();
+    ymin.clear(); ymax.clear();
+    zmin.clear(); zmax.clear();
+}
+
+void EventData::Reserve(std::size_t nTracks, std::size_t nPoints)
+{
+    x.reserve(nPoints);
+    y.reserve(nPoints);
+    z.reserve(nPoints);
+    offsets.reserve(nTracks + 1);
+    tid.reserve(nTracks);
+    pid.reserve(nTracks);
+    pdg.reserve(nTracks);
+    kinE.reserve(nTracks);
+}
+
+void EventData::AddTrack(int trackTID, int trackPID, int trackPDG, float trackKinE, uint32_t n)
+{
+    tid.push_back(trackTID);
+    pid.push_back(trackPID);
+    pdg.push_back(trackPDG);
+    kinE.push_back(trackKinE);
+    offsets.push_back(offsets.back() + n);
+}
+
+void EventData::SetPointsFromMM(const double* xmm, const double* ymm, const double* zmm)
+{
+    const std::size_t n = offsets.back();
+    const double mm_to_cm = 1e-1;
+
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    ScaleToFloat(xmm, x.data(), n, mm_to_cm);
+    ScaleToFloat(ymm, y.data(), n, mm_to_cm);
+    ScaleToFloat(zmm, z.data(), n, mm_to_cm);
+}
+
+std::size_t EventData::Bytes() const
+{
+    return sizeof(EventData)
+         + (3 * x.capacity() + significance.capacity()) * sizeof(float)
+         + offsets.capacity() * sizeof(uint32_t)
+         + (tid.capacity() + pid.capacity() + pdg.capacity()) * sizeof(int)
+         + kinE.capacity() * sizeof(float)
+         + 8 * length.capacity() * sizeof(float);
+}
+
+std::vector<char> SelectTracks(std::size_t n, const int* pid, const float* kinE, const uint32_t* nPoints, int64_t maxPoints)
+{
+    std::vector<char> keep(n, 1);
+    int64_t total = 0;
+    for (std::size_t t = 0; t < n; ++t) total += nPoints[t];
+    if (maxPoints <= 0 || total <= maxPoints) return keep;
+
+    // the order of DataManager::StartBuild, whose cuts are not known yet
+    std::vector<uint32_t> order(n);
+    for (std::size_t t = 0; t < n; ++t) order[t] = t;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        const bool pa = pid[a] == 0, pb = pid[b] == 0;
+        return pa != pb ? pa : kinE[a] > kinE[b];
+    });
+    int64_t kept = 0;
+    for (uint32_t t : order) {
+        if (kept + nPoints[t] > maxPoints) keep[t] = 0;
+        else kept += nPoints[t];
+    }
+    return keep;
+}
@@ -0,0 +1,125 @@
+#include "EventIndex.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+
+#include "TString.h"
+#include "TSystem.h"
+#include "TTreeReaderValue.h"
+
+#include "CacheDirectory.hh"
+#include "CompactEventFile.hh"
+
+namespace {
+    // bump the version whenever Entry or the file layout changes
+    const SidecarFormat kIndexFormat = {"FPFIDX\0\0", 1, sizeof(EventIndex::Entry)};
+}
+
+EventIndex::Key EventIndex::MakeKey(TFile* file, const std::string& filename)
+{
+    Key key = MakeKey(filename);
+    if (!file) return key;
+    key.uuid = file->GetUUID().AsString();
+    key.size = file->GetSize();
+    return key;
+}
+
+EventIndex::Key EventIndex::MakeKey(const std::string& filename)
+{
+    Key key;
+    key.path = gSystem->IsAbsoluteFileName(filename.c_str()) ? filename
+                                                             : std::string(gSystem->WorkingDirectory()) + "/" + filename;
+
+    FileStat_t st;
+    if (gSystem->GetPathInfo(filename.c_str(), st) == 0) {
+        key.size = st.fSize;
+        key.mtime = st.fMtime;
+    }
+    return key;
+}
+
+std::string EventIndex::SidecarPath(const Key& key)
+{
+    return GetCacheFile(key.path, ".idx");
+}
+
+bool EventIndex::Build(TTreeReader& reader)
+{
+    entries_.clear();
+
+    TTreeReaderValue<int> evtID(reader, "evtID");
+    TTreeReaderValue<int> nPoints(reader, "trackNPoints");
+    std::unordered_map<int, std::size_t> slots;
+
+    // FPFSim writes the tracks of one event contiguously, so in practice
+    // every event is a single run of entries: extend the current run while
+    // the evtID does not change and only look up the map on a new run
+    std::size_t current = 0;
+    while (reader.Next()) {
+        const Long64_t entry = reader.GetCurrentEntry();
+        const int id = *evtID;
+
+        if (entries_.empty() || entries_[current].evtID != id) {
+            auto it = slots.find(id);
+            if (it == slots.end()) {
+                current = entries_.size();
+                slots.emplace(id, current);
+                entries_.push_back({id, 0, entry, entry + 1, 0});
+            } else {
+                // event split in several runs: widen its range,
+                // LoadEvent still checks the evtID of each entry
+                current = it->second;
+            }
+        }
+
+        Entry& e = entries_[current];
+        e.last = entry + 1;
+        e.nTracks += 1;
+        e.nPoints += *nPoints;
+    }
+    reader.Restart();
+
+    std::sort(entries_.begin(), entries_.end(),
+              [](const Entry& a, const Entry& b) { return a.evtID < b.evtID; });
+
+    return !entries_.empty();
+}
+
+bool EventIndex::Build(const CompactEventFile& file)
+{
+    entries_.clear();
+    entries_.reserve(file.NEvents());
+    for (std::size_t i = 0; i < file.NEvents(); ++i) {
+        const CompactEventFile::Event& e = file.GetEvent(i);
+        entries_.push_back({e.evtID, int(e.nTracks), Long64_t(i), Long64_t(i) + 1, Long64_t(e.nPoints)});
+    }
+    return !entries_.empty();
+}
+
+bool EventIndex::Load(const std::string& path, const Key& key)
+{
+    return ReadSidecar(path, kIndexFormat, key, entries_);
+}
+
+bool EventIndex::Save(const std::string& path, const Key& key) const
+{
+    return WriteSidecar(path, kIndexFormat, key, entries_.data(), entries_.size());
+}
+
+const EventIndex::Entry* EventIndex::Find(int evtID) const
+{
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), evtID,
+                               [](const Entry& e, int id) { return e.evtID < id; });
+    if (it == entries_.end() || it->evtID != evtID) return nullptr;
+    return &(*it);
+}
+
+std::vector<int> EventIndex::GetEventIDs() const
+{
+    std::vector<int> ids;
+    ids.reserve(entries_.size());
+    for (const auto& e : entries_) ids.push_back(e.evtID);
+    return ids;
+}
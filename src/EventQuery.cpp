@@ -0,0 +1,309 @@
+#include "EventQuery.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <sstream>
+
+namespace {
+    struct Token {
+        enum Type { kEnd, kNumber, kName, kOp } type;
+        std::string text;
+        double value = 0;
+    };
+
+    /// Split a query in numbers, names and operators
+    bool Tokenize(const std::string& text, std::vector<Token>& tokens, std::string& error)
+    {
+        static const char* ops[] = {"&&", "||", "==", "!=", "<=", ">=", "<", ">", "!", "+", "-", "*", "/", "(", ")"};
+        std::size_t i = 0;
+        while (i < text.size()) {
+            if (std::isspace((unsigned char) text[i])) { ++i; continue; }
+
+            if (std::isdigit((unsigned char) text[i]) || text[i] == '.') {
+                char* end = nullptr;
+                const double value = std::strtod(text.c_str() + i, &end);
+                const std::size_t n = end - (text.c_str() + i);
+                if (n == 0) { error = "Bad number at '" + text.substr(i) + "'"; return false; }
+                tokens.push_back({Token::kNumber, text.substr(i, n), value});
+                i += n;
+                continue;
+            }
+
+            if (std::isalpha((unsigned char) text[i]) || text[i] == '_') {
+                std::size_t n = 1;
+                while (i + n < text.size() && (std::isalnum((unsigned char) text[i+n]) || text[i+n] == '_')) ++n;
+                tokens.push_back({Token::kName, text.substr(i, n)});
+                i += n;
+                continue;
+            }
+
+            bool found = false;
+            for (const char* op : ops) {
+                const std::size_t n = std::char_traits<char>::length(op);
+                if (text.compare(i, n, op) == 0) {
+                    tokens.push_back({Token::kOp, op});
+                    i += n;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) { error = "Unexpected '" + text.substr(i, 1) + "'"; return false; }
+        }
+        tokens.push_back({Token::kEnd, ""});
+        return true;
+    }
+
+    /// Recursive descent from the tokens to a postfix program
+    class Parser {
+    public:
+        Parser(const std::vector<Token>& tokens, std::size_t pos) : tokens_(tokens), pos_(pos) {}
+
+        bool Expression(EventQuery::Program& out) { return Or(out); }
+        std::size_t Pos() const { return pos_; }
+        const std::string& Error() const { return error_; }
+
+    private:
+        typedef EventQuery::Instr Instr;
+        const std::vector<Token>& tokens_;
+        std::size_t pos_;
+        std::string error_;
+
+        const Token& Peek() const { return tokens_[pos_]; }
+        bool Accept(const char* op, const char* word = nullptr)
+        {
+            const Token& t = Peek();
+            if ((t.type == Token::kOp && t.text == op) || (word && t.type == Token::kName && t.text == word)) {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+        bool Fail(const std::string& what)
+        {
+            if (error_.empty())
+                error_ = what + (Peek().type == Token::kEnd ? " at the end" : " at '" + Peek().text + "'");
+            return false;
+        }
+
+        bool Or(EventQuery::Program& out)
+        {
+            if (!And(out)) return false;
+            while (Accept("||", "or")) {
+                if (!And(out)) return false;
+                out.push_back({Instr::kOr, 0, -1});
+            }
+            return true;
+        }
+
+        bool And(EventQuery::Program& out)
+        {
+            if (!Compare(out)) return false;
+            while (Accept("&&", "and")) {
+                if (!Compare(out)) return false;
+                out.push_back({Instr::kAnd, 0, -1});
+            }
+            return true;
+        }
+
+        bool Compare(EventQuery::Program& out)
+        {
+            if (!Sum(out)) return false;
+            static const std::pair<const char*, Instr::Op> ops[] = {
+                {"<=", Instr::kLe}, {">=", Instr::kGe}, {"<", Instr::kLt}, {">", Instr::kGt},
+                {"==", Instr::kEq}, {"!=", Instr::kNe}};
+            for (const auto& op : ops) {
+                if (Accept(op.first)) {
+                    if (!Sum(out)) return false;
+                    out.push_back({op.second, 0, -1});
+                    return true;
+                }
+            }
+            return true;
+        }
+
+        bool Sum(EventQuery::Program& out)
+        {
+            if (!Product(out)) return false;
+            for (;;) {
+                Instr::Op op;
+                if (Accept("+")) op = Instr::kAdd;
+                else if (Accept("-")) op = Instr::kSub;
+                else return true;
+                if (!Product(out)) return false;
+                out.push_back({op, 0, -1});
+            }
+        }
+
+        bool Product(EventQuery::Program& out)
+        {
+            if (!Unary(out)) return false;
+            for (;;) {
+                Instr::Op op;
+                if (Accept("*")) op = Instr::kMul;
+                else if (Accept("/")) op = Instr::kDiv;
+                else return true;
+                if (!Unary(out)) return false;
+                out.push_back({op, 0, -1});
+            }
+        }
+
+        bool Unary(EventQuery::Program& out)
+        {
+            if (Accept("!", "not")) {
+                if (!Unary(out)) return false;
+                out.push_back({Instr::kNot, 0, -1});
+                return true;
+            }
+            if (Accept("-")) {
+                if (!Unary(out)) return false;
+                out.push_back({Instr::kNeg, 0, -1});
+                return true;
+            }
+            return Primary(out);
+        }
+
+        bool Primary(EventQuery::Program& out)
+        {
+            const Token t = Peek();
+            if (t.type == Token::kNumber) {
+                ++pos_;
+                out.push_back({Instr::kNumber, t.value, -1});
+                return true;
+            }
+            if (Accept("(")) {
+                if (!Or(out)) return false;
+                return Accept(")") ? true : Fail("Missing ')'");
+            }
+            if (t.type != Token::kName) return Fail("Expected a value");
+
+            ++pos_;
+            if (t.text == "abs" || t.text == "sqrt") {
+                if (!Accept("(")) return Fail("Expected '(' after " + t.text);
+                if (!Or(out)) return false;
+                if (!Accept(")")) return Fail("Missing ')'");
+                out.push_back({t.text == "abs" ? Instr::kAbs : Instr::kSqrt, 0, -1});
+                return true;
+            }
+            const int column = EventSummary::FindColumn(t.text);
+            if (column < 0) {
+                --pos_;
+                return Fail("Unknown column");
+            }
+            out.push_back({Instr::kColumn, 0, column});
+            return true;
+        }
+    };
+}
+
+bool EventQuery::Parse(const std::string& text, std::string& error)
+{
+    filter_.clear();
+    sort_.clear();
+    descending_ = false;
+    error.clear();
+
+    std::vector<Token> tokens;
+    if (!Tokenize(text, tokens, error)) return false;
+    auto isWord = [&](std::size_t i, const char* word) { return tokens[i].type == Token::kName && tokens[i].text == word; };
+
+    std::size_t pos = 0;
+    if (tokens[pos].type != Token::kEnd && !isWord(pos, "sort")) {
+        Parser parser(tokens, pos);
+        if (!parser.Expression(filter_)) {
+            error = parser.Error();
+            return false;
+        }
+        pos = parser.Pos();
+    }
+
+    if (isWord(pos, "sort")) {
+        ++pos;
+        if (isWord(pos, "by")) ++pos;
+        Parser parser(tokens, pos);
+        if (!parser.Expression(sort_)) {
+            error = parser.Error();
+            return false;
+        }
+        pos = parser.Pos();
+        if (isWord(pos, "desc")) { descending_ = true; ++pos; }
+        else if (isWord(pos, "asc")) ++pos;
+    }
+
+    if (tokens[pos].type != Token::kEnd) {
+        error = "Unexpected '" + tokens[pos].text + "'";
+        filter_.clear();
+        sort_.clear();
+        return false;
+    }
+    return true;
+}
+
+double EventQuery::Eval(const Program& program, const EventSummary::Row& row, std::vector<double>& stack)
+{
+    const auto& columns = EventSummary::GetColumns();
+    stack.clear();
+    for (const Instr& in : program) {
+        if (in.op == Instr::kNumber) { stack.push_back(in.value); continue; }
+        if (in.op == Instr::kColumn) { stack.push_back(columns[in.column].get(row)); continue; }
+
+        double& a = stack[stack.size() - (in.op <= Instr::kSqrt ? 1 : 2)];
+        const double b = stack.back();
+        switch (in.op) {
+            case Instr::kNeg:  a = -a; break;
+            case Instr::kNot:  a = (a == 0); break;
+            case Instr::kAbs:  a = std::fabs(a); break;
+            case Instr::kSqrt: a = std::sqrt(a); break;
+            case Instr::kAdd:  a = a + b; break;
+            case Instr::kSub:  a = a - b; break;
+            case Instr::kMul:  a = a * b; break;
+            case Instr::kDiv:  a = a / b; break;
+            case Instr::kLt:   a = a < b; break;
+            case Instr::kLe:   a = a <= b; break;
+            case Instr::kGt:   a = a > b; break;
+            case Instr::kGe:   a = a >= b; break;
+            case Instr::kEq:   a = a == b; break;
+            case Instr::kNe:   a = a != b; break;
+            case Instr::kAnd:  a = (a != 0) && (b != 0); break;
+            case Instr::kOr:   a = (a != 0) || (b != 0); break;
+            default: break;
+        }
+        if (in.op > Instr::kSqrt) stack.pop_back();
+    }
+    return stack.empty() ? 0 : stack.back();
+}
+
+std::vector<std::size_t> EventQuery::Select(const std::vector<EventSummary::Row>& rows) const
+{
+    std::vector<double> stack;
+    stack.reserve(16);
+
+    std::vector<std::size_t> selected;
+    selected.reserve(rows.size());
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        if (filter_.empty() || Eval(filter_, rows[i], stack) != 0) selected.push_back(i);
+    }
+
+    // sort keys computed once, ties keep the row order. NaN keys (0/0,
+    // sqrt of a negative) do not compare: those events go last, in row order
+    if (!sort_.empty()) {
+        std::vector<double> keys(rows.size());
+        for (std::size_t i : selected) keys[i] = Eval(sort_, rows[i], stack);
+        auto nan = std::stable_partition(selected.begin(), selected.end(),
+                                         [&](std::size_t i) { return !std::isnan(keys[i]); });
+        std::stable_sort(selected.begin(), nan, [&](std::size_t a, std::size_t b) {
+            return descending_ ? keys[a] > keys[b] : keys[a] < keys[b];
+        });
+    }
+    return selected;
+}
+
+std::string EventQuery::GetHelp()
+{
+    std::ostringstream ss;
+    for (const auto& c : EventSummary::GetColumns()) ss << c.name << ": " << c.description << "\n";
+    ss << "Events whose sort key is not a number (0/0, sqrt of a negative) come last.\n";
+    return ss.str();
+}
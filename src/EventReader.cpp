@@ -0,0 +1,272 @@
+#include "EventReader.hh"
+
+#include <iostream>
+
+#include "TROOT.h"
+#include "TTree.h"
+#include "TTreeCacheUnzip.h"
+#include "TTreePerfStats.h"
+#include "TTreeReaderValue.h"
+#include "TTreeReaderArray.h"
+#include "TVirtualPerfStats.h"
+
+#include "CompactEventFile.hh"
+#include "StageTimer.hh"
+#include "TrackQuantities.hh"
+#include "TrackSimplify.hh"
+
+EventReader::EventReader()
+    : file_(nullptr) {}
+
+EventReader::~EventReader()
+{
+    Close();
+}
+
+bool EventReader::Open(const std::string& filename)
+{
+    Close();
+
+    if (CompactEventFile::IsCompact(filename)) {
+        compact_.reset(new CompactEventFile());
+        if (!compact_->Open(filename)) {
+            compact_.reset();
+            return false;
+        }
+        return true;
+    }
+
+    file_ = TFile::Open(filename.c_str(),"READ");
+    if( !file_ || file_->IsZombie() ){
+        std::cerr << "[EventReader] Error opening file " << filename << std::endl;
+        delete file_;
+        file_ = nullptr;
+        return false;
+    }
+
+    std::string treeName = "trk";
+    reader_.SetTree(treeName.c_str(), file_);
+    if (!reader_.GetTree() ) {
+        std::cerr << "[EventReader] Could not find '" << treeName << "' tree "<< std::endl;
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void EventReader::Close()
+{
+    if(file_) {
+        if (perfStats_ && reader_.GetTree()) reader_.GetTree()->SetPerfStats(nullptr);
+        file_->Close();
+        delete file_;
+        file_ = nullptr;
+    }
+    delete perfStats_;
+    perfStats_ = nullptr;
+    treeReady_ = false;
+    compact_.reset();
+}
+
+bool EventReader::BuildIndex(EventIndex& index)
+{
+    if (compact_) return index.Build(*compact_);
+    return file_ && index.Build(reader_);
+}
+
+namespace {
+    ReadOptions gReadOptions;
+}
+
+void EventReader::SetOptions(const ReadOptions& options)
+{
+    gReadOptions = options;
+    if (options.unzipThreads > 0 && !ROOT::IsImplicitMTEnabled()) {
+        ROOT::EnableImplicitMT(options.unzipThreads);
+        std::cout << "[EventReader] Decompressing baskets with " << ROOT::GetThreadPoolSize() << " threads" << std::endl;
+    }
+}
+
+const ReadOptions& EventReader::GetOptions()
+{
+    return gReadOptions;
+}
+
+const std::vector<std::string>& EventReader::GetBranches()
+{
+    static const std::vector<std::string> branches = {
+        "evtID", "trackTID", "trackPID", "trackPDG", "trackKinE", "trackNPoints",
+        "trackPointX", "trackPointY", "trackPointZ"};
+    return branches;
+}
+
+void EventReader::SetUpTree()
+{
+    treeReady_ = true;
+    TTree* tree = reader_.GetTree();
+
+    // FPFSim trees have more branches (steps, hits, ...) that the display never needs
+    tree->SetBranchStatus("*", false);
+    for (const std::string& name : GetBranches()) tree->SetBranchStatus(name.c_str(), true);
+
+    // one large read per cluster for exactly these branches: what matters on
+    // remote storage, where each read call costs a round trip
+    if (gReadOptions.cacheBytes > 0) {
+        if (gReadOptions.unzipThreads > 0) TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::kEnable);
+        tree->SetCacheSize(gReadOptions.cacheBytes);
+        if (gReadOptions.prefill) {
+            for (const std::string& name : GetBranches()) tree->AddBranchToCache(name.c_str(), false);
+            tree->StopCacheLearningPhase();
+        }
+    } else {
+        tree->SetCacheSize(0);
+    }
+
+    // baskets decompressed by the implicit-MT pool are not seen by the perf stats
+    if (gReadOptions.stats && gReadOptions.unzipThreads == 0) {
+        TVirtualPerfStats* previous = gPerfStats;
+        perfStats_ = new TTreePerfStats("FPFDisplayIO", tree);
+        gPerfStats = previous;
+    }
+}
+
+namespace {
+    // append the content of a TTreeReaderArray, in one block if the
+    // underlying buffer is contiguous (always the case for FPFSim trees)
+    void Append(TTreeReaderArray<double>& arr, std::vector<double>& out)
+    {
+        const std::size_t n = arr.GetSize();
+        if (n == 0) return;
+        if (n == 1 || &arr[1] - &arr[0] == 1) {
+            out.insert(out.end(), &arr[0], &arr[0] + n);
+        } else {
+            for (std::size_t k = 0; k < n; ++k) out.push_back(arr[k]);
+        }
+    }
+}
+
+bool EventReader::ReadEvent(const EventIndex::Entry& range, EventData& data, const std::atomic<bool>* cancel)
+{
+    if (compact_) {
+        // decoded from the mapping, with the quantities stored by FPFConvert
+        if (!compact_->ReadEvent(range.first, data, cancel, maxPoints_)) return false;
+        if (data.evtID != range.evtID) {
+            std::cerr << "[EventReader] Entry " << range.first << " holds event " << data.evtID << ", not " << range.evtID << std::endl;
+            return false;
+        }
+        data.bytesRead = compact_->GetEvent(range.first).bytes;
+        return true;
+    }
+
+    data.Clear();
+    data.evtID = range.evtID;
+    const bool capped = maxPoints_ > 0 && range.nPoints > maxPoints_;
+    data.Reserve(range.nTracks, capped ? maxPoints_ : range.nPoints);
+
+    // raw points in mm, reused across events
+    xmm_.clear();
+    ymm_.clear();
+    zmm_.clear();
+
+    if (!treeReady_) SetUpTree();
+
+    TTreeReaderValue<int> evtID_(reader_,"evtID");
+    TTreeReaderValue<int> trackTID_(reader_,"trackTID");
+    TTreeReaderValue<int> trackPID_(reader_,"trackPID");
+    TTreeReaderValue<int> trackPDG_(reader_,"trackPDG");
+    TTreeReaderValue<double> trackKinE_(reader_,"trackKinE");
+    TTreeReaderValue<int> trackNPoints_(reader_,"trackNPoints");
+    TTreeReaderArray<double> trackPointX_(reader_,"trackPointX");
+    TTreeReaderArray<double> trackPointY_(reader_,"trackPointY");
+    TTreeReaderArray<double> trackPointZ_(reader_,"trackPointZ");
+
+    // the perf stats hook is per thread: only this reader's baskets are counted
+    const Long64_t bytesBefore = file_->GetBytesRead();
+    const Int_t callsBefore = file_->GetReadCalls();
+    const double unzipBefore = perfStats_ ? perfStats_->GetUnzipTime() : 0;
+    TVirtualPerfStats* previousStats = gPerfStats;
+    if (perfStats_) gPerfStats = perfStats_;
+
+    // only read the entries of the selected event
+    if (reader_.SetEntriesRange(range.first, range.last) != TTreeReader::kEntryValid) {
+        std::cerr << "[EventReader] Could not read entries [" << range.first << ", " << range.last << ") of event " << range.evtID << std::endl;
+        gPerfStats = previousStats;
+        return false;
+    }
+
+    bool ok = true;
+
+    // over the point cap, a first pass over the track columns picks the
+    // tracks to decode: the point arrays of the others are not even unpacked
+    std::vector<char> keep;
+    if (capped) {
+        std::vector<int> pid;
+        std::vector<float> kinE;
+        std::vector<uint32_t> nPoints;
+        while (reader_.Next()) {
+            // entries of another event count as empty primaries, skipped below
+            const bool selected = *evtID_ == range.evtID;
+            pid.push_back(selected ? *trackPID_ : 0);
+            kinE.push_back(selected ? *trackKinE_ : 0);
+            nPoints.push_back(selected ? *trackNPoints_ : 0);
+        }
+        keep = SelectTracks(pid.size(), pid.data(), kinE.data(), nPoints.data(), maxPoints_);
+        for (std::size_t t = 0; t < keep.size(); ++t) {
+            if (keep[t]) continue;
+            ++data.nCappedTracks;
+            data.nCappedPoints += nPoints[t];
+        }
+        if (reader_.SetEntriesRange(range.first, range.last) != TTreeReader::kEntryValid) {
+            std::cerr << "[EventReader] Could not read entries [" << range.first << ", " << range.last << ") of event " << range.evtID << std::endl;
+            ok = false;
+        }
+    }
+
+    for (std::size_t entry = 0; ok && reader_.Next(); ++entry) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            ok = false;
+            break;
+        }
+
+        //select event
+        if( *evtID_ != range.evtID ) continue;
+        if (capped && !keep[entry]) continue;
+
+        // trackNPoints and the array sizes should agree, trust the arrays
+        const std::size_t before = xmm_.size();
+        Append(trackPointX_, xmm_);
+        Append(trackPointY_, ymm_);
+        Append(trackPointZ_, zmm_);
+        const std::size_t npts = xmm_.size() - before;
+        if (ymm_.size() != xmm_.size() || zmm_.size() != xmm_.size()) {
+            std::cerr << "[EventReader] Inconsistent point arrays for track " << *trackTID_ << " of event " << range.evtID << std::endl;
+            ok = false;
+            break;
+        }
+        if (npts != static_cast<std::size_t>(*trackNPoints_))
+            std::cerr << "[EventReader] Track " << *trackTID_ << " has " << npts << " points, expected " << *trackNPoints_ << std::endl;
+
+        data.AddTrack(*trackTID_, *trackPID_, *trackPDG_, *trackKinE_, npts);
+    }
+
+    gPerfStats = previousStats;
+    data.bytesRead = file_->GetBytesRead() - bytesBefore;
+    data.readCalls = file_->GetReadCalls() - callsBefore;
+    if (perfStats_) {
+        data.unzipMs = 1000 * (perfStats_->GetUnzipTime() - unzipBefore);
+        StageStats::Instance().Record("event.unzip", data.unzipMs, range.evtID);
+    }
+    if (!ok || (cancel && cancel->load(std::memory_order_relaxed))) return false;
+
+    // single vectorized mm -> cm conversion for the whole event
+    data.SetPointsFromMM(xmm_.data(), ymm_.data(), zmm_.data());
+
+    // per-track length, bounding box, ... computed once and cached with the event
+    ComputeTrackQuantities(data);
+
+    // simplification levels are derived from this at display time
+    ComputeSignificance(data);
+
+    return true;
+}
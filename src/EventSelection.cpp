@@ -0,0 +1,78 @@
+#include "EventSelection.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+
+namespace {
+
+    /// Append the IDs of one "N" or "A-B" item, returns false if malformed
+    bool AddItem(const std::string& item, const std::vector<int>& available, std::vector<int>& out)
+    {
+        int first = 0, last = 0;
+        char dash = 0, extra = 0;
+        const int n = std::sscanf(item.c_str(), " %d %c %d %c", &first, &dash, &last, &extra);
+        if (n == 1) last = first;
+        else if (n != 3 || dash != '-' || last < first) return false;
+
+        auto begin = std::lower_bound(available.begin(), available.end(), first);
+        auto end = std::upper_bound(available.begin(), available.end(), last);
+        if (begin == end) {
+            std::cerr << "[EventSelection] No event " << first;
+            if (last != first) std::cerr << "-" << last;
+            std::cerr << " in the file" << std::endl;
+            return true;
+        }
+        out.insert(out.end(), begin, end);
+        return true;
+    }
+}
+
+std::vector<int> SelectEvents(const std::string& spec, const std::vector<int>& available)
+{
+    if (spec.empty() || spec == "all") return available;
+
+    std::string items = spec;
+    char separator = ',';
+    if (spec[0] == '@') {
+        std::ifstream in(spec.substr(1));
+        if (!in) {
+            std::cerr << "[EventSelection] Cannot open event list " << spec.substr(1) << std::endl;
+            return {};
+        }
+        std::stringstream text;
+        text << in.rdbuf();
+        items = text.str();
+        separator = '\n';
+    }
+
+    std::vector<int> selected;
+    std::stringstream list(items);
+    for (std::string item; std::getline(list, item, separator); ) {
+        item = item.substr(0, item.find('#'));
+        if (item.find_first_not_of(" \t\r") == std::string::npos) continue;
+        if (!AddItem(item, available, selected))
+            std::cerr << "[EventSelection] Invalid event or range: " << item << std::endl;
+    }
+    return selected;
+}
+
+std::string FormatEventFileName(const std::string& pattern, int evtID)
+{
+    static const std::regex placeholder("%(0?[0-9]*)d");
+    std::smatch match;
+    if (std::regex_search(pattern, match, placeholder)) {
+        char id[32];
+        std::snprintf(id, sizeof(id), ("%" + match[1].str() + "d").c_str(), evtID);
+        return match.prefix().str() + id + match.suffix().str();
+    }
+
+    const std::size_t dot = pattern.find_last_of('.');
+    const std::size_t slash = pattern.find_last_of('/');
+    const std::string suffix = "_" + std::to_string(evtID);
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return pattern + suffix;
+    return pattern.substr(0, dot) + suffix + pattern.substr(dot);
+}
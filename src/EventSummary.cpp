@@ -0,0 +1,242 @@
+#include "EventSummary.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+
+#include "ROOT/TSeq.hxx"
+#include "ROOT/TThreadExecutor.hxx"
+#include "TFile.h"
+#include "TROOT.h"
+#include "TTree.h"
+#include "TTreeReader.h"
+#include "TTreeReaderArray.h"
+#include "TTreeReaderValue.h"
+
+#include "CacheDirectory.hh"
+#include "CompactEventFile.hh"
+
+namespace {
+    // bump the version whenever Row or the file layout changes
+    const SidecarFormat kSummaryFormat = {"FPFSUM\0\0", 1, sizeof(EventSummary::Row)};
+
+    EventSummary::Row EmptyRow(int evtID)
+    {
+        EventSummary::Row r;
+        std::memset(&r, 0, sizeof(r));
+        r.evtID = evtID;
+        r.maxPrimaryE = -1; // no primary yet, see Merge
+        return r;
+    }
+
+    /// Count one track, (x0, y0, z0) being its first point in cm
+    void AddTrack(EventSummary::Row& r, int pid, int pdg, double kinE, std::size_t nPoints, float x0, float y0, float z0)
+    {
+        r.nTracks += 1;
+        r.nPoints += nPoints;
+        const int apdg = std::abs(pdg);
+        if (apdg == 13) {
+            r.nMuons += 1;
+            r.maxMuonE = std::max(r.maxMuonE, float(kinE));
+        }
+        else if (apdg == 11) r.nElectrons += 1;
+        else if (pdg == 22) r.nPhotons += 1;
+        else if (apdg == 211 || pdg == 111) r.nPions += 1;
+        else if (pdg == 2212) r.nProtons += 1;
+        else if (pdg == 2112) r.nNeutrons += 1;
+
+        // primary tracks have no parent
+        if (pid == 0) {
+            r.nPrimaries += 1;
+            if (kinE > r.maxPrimaryE && nPoints > 0) {
+                r.maxPrimaryE = kinE;
+                r.vtxX = x0;
+                r.vtxY = y0;
+                r.vtxZ = z0;
+            }
+        }
+    }
+
+    /// Combine the tracks of one event seen in different ranges of entries
+    void Merge(EventSummary::Row& a, const EventSummary::Row& b)
+    {
+        a.nTracks    += b.nTracks;
+        a.nPrimaries += b.nPrimaries;
+        a.nMuons     += b.nMuons;
+        a.nElectrons += b.nElectrons;
+        a.nPhotons   += b.nPhotons;
+        a.nPions     += b.nPions;
+        a.nProtons   += b.nProtons;
+        a.nNeutrons  += b.nNeutrons;
+        a.nPoints    += b.nPoints;
+        a.maxMuonE = std::max(a.maxMuonE, b.maxMuonE);
+        if (b.maxPrimaryE > a.maxPrimaryE) {
+            a.maxPrimaryE = b.maxPrimaryE;
+            a.vtxX = b.vtxX;
+            a.vtxY = b.vtxY;
+            a.vtxZ = b.vtxZ;
+        }
+    }
+}
+
+const std::vector<EventSummary::Column>& EventSummary::GetColumns()
+{
+    static const std::vector<Column> columns = {
+        {"evtID",       "event ID",                                [](const Row& r) { return double(r.evtID); }},
+        {"nTracks",     "number of tracks",                        [](const Row& r) { return double(r.nTracks); }},
+        {"nPrimaries",  "number of primary tracks",                [](const Row& r) { return double(r.nPrimaries); }},
+        {"nSecondaries","number of secondary tracks",              [](const Row& r) { return double(r.nTracks - r.nPrimaries); }},
+        {"nMuons",      "number of muons",                         [](const Row& r) { return double(r.nMuons); }},
+        {"nElectrons",  "number of electrons and positrons",       [](const Row& r) { return double(r.nElectrons); }},
+        {"nPhotons",    "number of photons",                       [](const Row& r) { return double(r.nPhotons); }},
+        {"nPions",      "number of charged and neutral pions",     [](const Row& r) { return double(r.nPions); }},
+        {"nProtons",    "number of protons",                       [](const Row& r) { return double(r.nProtons); }},
+        {"nNeutrons",   "number of neutrons",                      [](const Row& r) { return double(r.nNeutrons); }},
+        {"nPoints",     "number of trajectory points",             [](const Row& r) { return double(r.nPoints); }},
+        {"maxPrimaryE", "highest primary kinetic energy [MeV]",    [](const Row& r) { return double(r.maxPrimaryE); }},
+        {"maxMuonE",    "highest muon kinetic energy [MeV]",       [](const Row& r) { return double(r.maxMuonE); }},
+        {"vtxX",        "x of the most energetic primary [cm]",    [](const Row& r) { return double(r.vtxX); }},
+        {"vtxY",        "y of the most energetic primary [cm]",    [](const Row& r) { return double(r.vtxY); }},
+        {"vtxZ",        "z of the most energetic primary [cm]",    [](const Row& r) { return double(r.vtxZ); }},
+    };
+    return columns;
+}
+
+int EventSummary::FindColumn(const std::string& name)
+{
+    const auto& columns = GetColumns();
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        if (name == columns[i].name) return i;
+    }
+    return -1;
+}
+
+bool EventSummary::Build(const std::string& filename, unsigned nThreads)
+{
+    if (CompactEventFile::IsCompact(filename)) return BuildCompact(filename);
+
+    rows_.clear();
+    auto start = std::chrono::steady_clock::now();
+
+    Long64_t nEntries = 0;
+    {
+        std::unique_ptr<TFile> file(TFile::Open(filename.c_str(), "READ"));
+        TTree* tree = file && !file->IsZombie() ? file->Get<TTree>("trk") : nullptr;
+        if (!tree) {
+            std::cerr << "[EventSummary] Could not find the 'trk' tree in " << filename << std::endl;
+            return false;
+        }
+        nEntries = tree->GetEntries();
+    }
+    if (nEntries == 0) return false;
+
+    // a pool of its own rather than the implicit MT, which is global: the
+    // event cache may be reading a tree meanwhile. Each range of entries
+    // opens the file again, with its own reader.
+    ROOT::EnableThreadSafety();
+    ROOT::TThreadExecutor pool(nThreads);
+    const unsigned nRanges = std::min<Long64_t>(nEntries, 4 * pool.GetPoolSize());
+    std::atomic<bool> failed(false);
+    auto summarize = [&](unsigned range) {
+        std::unordered_map<int, Row> rows;
+        std::unique_ptr<TFile> file(TFile::Open(filename.c_str(), "READ"));
+        if (!file || file->IsZombie()) {
+            failed = true;
+            return rows;
+        }
+        TTreeReader reader("trk", file.get());
+        TTreeReaderValue<int> evtID(reader, "evtID");
+        TTreeReaderValue<int> pid(reader, "trackPID");
+        TTreeReaderValue<int> pdg(reader, "trackPDG");
+        TTreeReaderValue<double> kinE(reader, "trackKinE");
+        TTreeReaderArray<double> x(reader, "trackPointX");
+        TTreeReaderArray<double> y(reader, "trackPointY");
+        TTreeReaderArray<double> z(reader, "trackPointZ");
+        if (reader.SetEntriesRange(nEntries * range / nRanges, nEntries * (range + 1) / nRanges) != TTreeReader::kEntryValid) {
+            failed = true;
+            return rows;
+        }
+        while (reader.Next()) {
+            auto it = rows.find(*evtID);
+            if (it == rows.end()) it = rows.emplace(*evtID, EmptyRow(*evtID)).first;
+            const std::size_t n = x.GetSize();
+            AddTrack(it->second, *pid, *pdg, *kinE, n, n ? x[0] / 10. : 0, // mm -> cm
+                     n ? y[0] / 10. : 0, n ? z[0] / 10. : 0);
+        }
+        if (reader.GetEntryStatus() != TTreeReader::kEntryBeyondEnd) failed = true;
+        return rows;
+    };
+
+    // an event may be split between ranges: rows are accumulated per range and merged afterwards
+    std::vector<std::unordered_map<int, Row>> partial = pool.Map(summarize, ROOT::TSeqU(nRanges));
+    if (failed) {
+        std::cerr << "[EventSummary] Failed to summarize " << filename << std::endl;
+        return false;
+    }
+
+    std::unordered_map<int, Row> merged;
+    for (auto& range : partial) {
+        for (auto& it : range) {
+            auto m = merged.find(it.first);
+            if (m == merged.end()) merged.emplace(it.first, it.second);
+            else Merge(m->second, it.second);
+        }
+    }
+    rows_.reserve(merged.size());
+    for (auto& it : merged) {
+        it.second.maxPrimaryE = std::max(it.second.maxPrimaryE, 0.f);
+        rows_.push_back(it.second);
+    }
+
+    std::sort(rows_.begin(), rows_.end(), [](const Row& a, const Row& b) { return a.evtID < b.evtID; });
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[EventSummary] Summarized " << rows_.size() << " events in " << ms << " ms" << std::endl;
+    return !rows_.empty();
+}
+
+bool EventSummary::BuildCompact(const std::string& filename)
+{
+    rows_.clear();
+    auto start = std::chrono::steady_clock::now();
+
+    // the track columns are read in place, only the first points are decoded
+    CompactEventFile file;
+    if (!file.Open(filename)) return false;
+    std::vector<float> x0, y0, z0;
+    rows_.reserve(file.NEvents());
+    for (std::size_t i = 0; i < file.NEvents(); ++i) {
+        const CompactEventFile::Event& e = file.GetEvent(i);
+        if (!file.GetFirstPoints(i, x0, y0, z0)) continue;
+        const CompactEventFile::Tracks tracks = file.GetTracks(i);
+        Row r = EmptyRow(e.evtID);
+        for (uint32_t t = 0; t < e.nTracks; ++t)
+            AddTrack(r, tracks.pid[t], tracks.pdg[t], tracks.kinE[t], tracks.nPoints[t], x0[t], y0[t], z0[t]);
+        r.maxPrimaryE = std::max(r.maxPrimaryE, 0.f);
+        rows_.push_back(r);
+    }
+
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[EventSummary] Summarized " << rows_.size() << " events in " << ms << " ms" << std::endl;
+    return !rows_.empty();
+}
+
+std::string EventSummary::SidecarPath(const EventIndex::Key& key)
+{
+    return GetCacheFile(key.path, ".sum");
+}
+
+bool EventSummary::Load(const std::string& path, const EventIndex::Key& key)
+{
+    return ReadSidecar(path, kSummaryFormat, key, rows_);
+}
+
+bool EventSummary::Save(const std::string& path, const EventIndex::Key& key) const
+{
+    return WriteSidecar(path, kSummaryFormat, key, rows_.data(), rows_.size());
+}
@@ -1,7 +1,12 @@
+#include <algorithm>
 #include <iostream>
+#include <chrono>
 
+#include "EventQuery.hh"
+#include "EventSelection.hh"
 #include "GUIDisplay.hh"
 #include "MultiView.hh"
+#include "StageTimer.hh"
 
 #include "TApplication.h"
 #include "TEveManager.h"
@@ -23,30 +28,55 @@ ClassImp(GUIDisplay)
 GUIDisplay::GUIDisplay() {}
 GUIDisplay::~GUIDisplay() {}
 
-void GUIDisplay::Initialize(const std::string& title)
+void GUIDisplay::Initialize(const std::string& title, bool batch)
 {
   // 1) Start up EVE
   std::cout << "[GUIDisplay] Initializing..." << std::endl;
 
-  TEveManager::Create();
+  // GL viewers need a GL context, so even batch mode creates the windows, unmapped
+  batch_ = batch;
+  TEveManager::Create(!batch);
   gEve->GetBrowser()->SetWindowName(title.c_str());
   gEve->GetBrowser()->HideBottomTab();
   gEve->GetBrowser()->SetTabTitle("3D View");
 
   // 2) Create multiple views and load the geometry
-  std::cout << "[GUIDisplay] Importing geometry..." << std::endl;
-
-  TEveGeoShape *geo = geomMgr_.ImportGentleGeometry();
-  gEve->AddGlobalElement(geo);
-
   std::cout << "[GUIDisplay] Setting up MultiView..." << std::endl;
   mv_ = new MultiView();
-  mv_->ImportGeomZX(geo);
-  mv_->ImportGeomZY(geo);
+
+  // detectors are extracted, imported and projected when first shown
+  std::cout << "[GUIDisplay] Importing geometry..." << std::endl;
+  geometry_ = new TEveElementList("Geometry");
+  gEve->AddGlobalElement(geometry_);
+  geometryZX_ = mv_->ImportGeomZX(geometry_);
+  geometryZY_ = mv_->ImportGeomZY(geometry_);
+
+  const auto& detectors = GeometryManager::GetDetectors();
+  detectorViews_.assign(detectors.size(), DetectorView());
+  for (std::size_t d = 0; d < detectors.size(); ++d) {
+    const bool show = detectorsRequested_.empty()
+      || std::find(detectorsRequested_.begin(), detectorsRequested_.end(), detectors[d].name) != detectorsRequested_.end();
+    if (show) ShowDetector(d, true);
+  }
+  ApplyGeometryBudgets();
 
   gEve->GetBrowser()->GetTabRight()->SetTab(1);
   
-  MakeControlTab();
+  if (!batch) {
+    MakeControlTab();
+
+    // large events are built chunk by chunk, with the GUI responsive in between
+    buildTimer_ = new TTimer(10);
+    buildTimer_->Connect("Timeout()", "GUIDisplay", this, "OnBuildTick()");
+
+    // events are decoded by the cache worker, the timer picks them up
+    loadTimer_ = new TTimer(20);
+    loadTimer_->Connect("Timeout()", "GUIDisplay", this, "OnLoadTick()");
+
+    // files are indexed in the background when searching all of them
+    searchTimer_ = new TTimer(100);
+    searchTimer_->Connect("Timeout()", "GUIDisplay", this, "OnSearchTick()");
+  }
 
   LoadEvent();
 
@@ -62,35 +92,179 @@ void GUIDisplay::LoadGeometry(const std::string& gdmlFile, const bool useDefault
   geomMgr_.LoadGDML(gdmlFile);
 }
 
-void GUIDisplay::LoadFile(const std::string& rootFile)
+void GUIDisplay::LoadFiles(const std::vector<std::string>& rootFiles)
+{
+  dataMgr_.LoadFiles(rootFiles);
+}
+
+void GUIDisplay::SetGeometryLOD(const GeometryLOD& lod)
+{
+  geomMgr_.SetLOD(lod);
+}
+
+void GUIDisplay::SetTriangleBudgets(Long64_t budget3D, Long64_t budgetZX, Long64_t budgetZY)
+{
+  triangleBudgets_[0] = budget3D;
+  triangleBudgets_[1] = budgetZX;
+  triangleBudgets_[2] = budgetZY;
+}
+
+void GUIDisplay::SetDetectors(const std::vector<std::string>& names)
+{
+  const auto& detectors = GeometryManager::GetDetectors();
+  detectorsRequested_.clear();
+  for (const std::string& name : names) {
+    auto known = std::find_if(detectors.begin(), detectors.end(),
+                              [&](const GeometryManager::Detector& d) { return d.name == name; });
+    if (known == detectors.end()) {
+      std::cerr << "[GUIDisplay] Unknown detector " << name << ", expected one of:";
+      for (const auto& d : detectors) std::cerr << " " << d.name;
+      std::cerr << std::endl;
+      continue;
+    }
+    detectorsRequested_.push_back(name);
+  }
+}
+
+void GUIDisplay::ShowDetector(std::size_t d, bool show)
+{
+  DetectorView& view = detectorViews_[d];
+  if (show && !view.loaded) {
+    view.loaded = true;
+    view.gentle = geomMgr_.ImportGentleGeometry(GeometryManager::GetDetectors()[d].name);
+    if (view.gentle) {
+      geometry_->AddElement(view.gentle);
+      view.zx = mv_->ImportGeomZX(view.gentle, geometryZX_);
+      view.zy = mv_->ImportGeomZY(view.gentle, geometryZY_);
+      geomBudget_.Add(view.gentle, geomMgr_.GetLOD().nSegments);
+    }
+  }
+
+  view.shown = show;
+  for (TEveElement* el : {view.gentle, view.zx, view.zy}) {
+    if (el) el->SetRnrState(show);
+  }
+}
+
+void GUIDisplay::ApplyGeometryBudgets()
+{
+  // the 3D budget first: hiding a 3D shape hides its projections too
+  geomBudget_.Apply(geometry_, triangleBudgets_[0], "3D");
+  if (geometryZX_) geomBudget_.Apply(geometryZX_, triangleBudgets_[1], "ZX");
+  if (geometryZY_) geomBudget_.Apply(geometryZY_, triangleBudgets_[2], "ZY");
+}
+
+void GUIDisplay::OnDetectorToggled()
+{
+  for (std::size_t d = 0; d < detectorViews_.size(); ++d) {
+    DetectorView& view = detectorViews_[d];
+    if (view.button && view.button->IsOn() != view.shown)
+      ShowDetector(d, view.button->IsOn());
+  }
+  ApplyGeometryBudgets();
+  gEve->Redraw3D();
+}
+
+void GUIDisplay::SetGeometryStyle(const std::string& styleFile)
+{
+  geomMgr_.SetStyleFile(styleFile);
+}
+
+void GUIDisplay::SetCacheOptions(int sizeMB, int prefetchDepth, int maxOpenFiles)
+{
+  dataMgr_.SetCacheSize(sizeMB);
+  dataMgr_.SetPrefetchDepth(prefetchDepth);
+  dataMgr_.SetMaxOpenFiles(maxOpenFiles);
+}
+
+void GUIDisplay::SetBuildOptions(Long64_t chunkVertices, Long64_t maxVertices)
 {
-  dataMgr_.LoadFile(rootFile);
+  dataMgr_.SetChunkVertices(chunkVertices);
+  dataMgr_.SetMaxVertices(maxVertices);
 }
 
-void GUIDisplay::LoadEvent()
+bool GUIDisplay::LoadEvent()
 {
   gEve->GetViewers()->DeleteAnnotations();
 
   // load current selected event 
   // if no file open, skip
-  if(dataMgr_.LoadEvent()){
-    TEveElement* top = gEve->GetCurrentEvent();
+  if (!dataMgr_.LoadEvent()) return false;
+  ShowEvent();
+  return true;
+}
 
-    mv_->DestroyEventZX();
-    mv_->ImportEventZX(top);
+void GUIDisplay::RequestEvent()
+{
+  if (batch_ || !loadTimer_) {
+    LoadEvent();
+    return;
+  }
 
-    mv_->DestroyEventZY();
-    mv_->ImportEventZY(top);
+  // the event shown so far stays until the new one is decoded
+  if (buildTimer_) buildTimer_->Stop();
+  if (!dataMgr_.RequestEvent()) return;
+  if (dataMgr_.IsLoading()) {
+    loadingLabel_->SetText(Form("Loading event %d...", dataMgr_.GetCurrentEvent()));
+    loadingLabel_->Resize(loadingLabel_->GetDefaultWidth(), loadingLabel_->GetDefaultHeight());
+    loadTimer_->Start(20, kFALSE);
+    OnLoadTick(); // cached events are there already
+  } else {
+    // no cache worker, loaded synchronously
+    gEve->GetViewers()->DeleteAnnotations();
+    ShowEvent();
+  }
+}
 
-    gEve->Redraw3D(kFALSE, kTRUE);
+void GUIDisplay::OnLoadTick()
+{
+  if (dataMgr_.PollEvent()) {
+    gEve->GetViewers()->DeleteAnnotations();
+    ShowEvent();
   }
+  if (!dataMgr_.IsLoading()) {
+    loadTimer_->Stop();
+    loadingLabel_->SetText("");
+    UpdateSummary();
+  }
+}
+
+void GUIDisplay::ShowEvent()
+{
+  // images are only saved once the whole event is there
+  if (batch_) while (dataMgr_.BuildNextChunk()) {}
+
+  TEveElement* top = gEve->GetCurrentEvent();
+
+  // the projected tracks are kept between events and only re-projected
+  mv_->UpdateEventZX(top);
+  mv_->UpdateEventZY(top);
 
+  // redraw right away rather than on the next idle, so it can be timed
+  StageTimer timer("event.redraw", dataMgr_.GetCurrentEvent());
+  gEve->Redraw3D(kFALSE, kTRUE);
+  gEve->DoRedraw3D();
+  timer.Stop();
+
+  if (buildTimer_) {
+    if (dataMgr_.IsEventComplete()) buildTimer_->Stop();
+    else buildTimer_->Start(10, kFALSE);
+  }
+}
+
+void GUIDisplay::OnBuildTick()
+{
+  // one chunk per tick, the GUI events queued meanwhile are handled in between;
+  // only the new tracks are projected
+  if (dataMgr_.BuildNextChunk()) ShowEvent();
+  else buildTimer_->Stop();
+  UpdateSummary();
 }
 
 void GUIDisplay::OnNextEvent()
 {
   if (dataMgr_.NextEvent()){
-    LoadEvent();
+    RequestEvent();
     UpdateSummary();
   } 
 }
@@ -98,7 +272,7 @@ void GUIDisplay::OnNextEvent()
 void GUIDisplay::OnPrevEvent()
 {
   if (dataMgr_.PrevEvent()){
-    LoadEvent();
+    RequestEvent();
     UpdateSummary();
   }
 }
@@ -113,7 +287,35 @@ void GUIDisplay::OnSave()
   std::string base = (dot != std::string::npos) ? filename.substr(0, dot) : filename;
   std::string ext = (dot != std::string::npos) ? filename.substr(dot) : ".png";
   std::string out = base+ext;
+  if (tiledCheck_) tiledExport_ = tiledCheck_->IsOn();
+
+  // saved images show the whole event
+  if (!dataMgr_.IsEventComplete()) {
+    while (dataMgr_.BuildNextChunk()) {}
+    ShowEvent();
+  }
 
+  // PNG: only grab the pixels here, they are encoded and written in the background
+  if (ext == ".png" || ext == ".PNG") {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ImageWriter::Image> images(1);
+    bool ok = ImageWriter::Grab(gEve->GetDefaultGLViewer(), imageScale_, out, images[0]);
+    ok &= mv_->GrabDisplays(base, ext, imageScale_, images);
+    if (!ok) {
+      std::cerr << "[GUIDisplay] Failed to grab the displays" << std::endl;
+      return;
+    }
+
+    if (tiledExport_) imageWriter_.WriteTiled(std::move(images), 2, out);
+    else imageWriter_.Write(std::move(images));
+
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[GUIDisplay] Displays grabbed in " << ms << " ms, writing " << (tiledExport_ ? "tiled " : "")
+              << "images in the background" << std::endl;
+    return;
+  }
+
+  if (tiledExport_) std::cerr << "[GUIDisplay] Tiled images are only written as PNG" << std::endl;
   std::cout << "[GUIDisplay] Saving main display to " << out << std::endl;
   if(imageScale_>0) gEve->GetDefaultGLViewer()->SavePictureScale(out.c_str(),imageScale_);
   else gEve->GetDefaultGLViewer()->SavePicture(out.c_str());
@@ -123,6 +325,131 @@ void GUIDisplay::OnSave()
 
 }
 
+bool GUIDisplay::RenderEvent(const EventRef& event, const std::string& pattern, int scale)
+{
+  if (!dataMgr_.GoToEvent(event)) return false;
+  const int evtID = event.evtID;
+
+  // geometry scenes are kept, only the event scenes are rebuilt;
+  // the first event also paints the geometry and places the cameras.
+  // A failed read leaves the previous tracks: nothing is saved then
+  if (!LoadEvent()) {
+    std::cerr << "[GUIDisplay] Could not load event " << evtID << ", no image written" << std::endl;
+    return false;
+  }
+  if (nRendered_ == 0) gEve->FullRedraw3D(kTRUE);
+
+  std::string out = FormatEventFileName(pattern, evtID);
+  if (dataMgr_.GetNFiles() > 1) {
+    // evtIDs repeat between the files of a production
+    TString stem = gSystem->BaseName(dataMgr_.GetFileName(event.file).c_str());
+    if (stem.EndsWith(".root")) stem.Remove(stem.Length() - 5);
+    out = std::string(gSystem->GetDirName(out.c_str()).Data()) + "/" + stem.Data() + "/" + gSystem->BaseName(out.c_str());
+  }
+  std::string dir = gSystem->GetDirName(out.c_str()).Data();
+  if (gSystem->AccessPathName(dir.c_str())) gSystem->mkdir(dir.c_str(), kTRUE);
+  std::size_t dot = out.find_last_of('.');
+  std::string base = (dot != std::string::npos) ? out.substr(0, dot) : out;
+  std::string ext = (dot != std::string::npos) ? out.substr(dot) : ".png";
+
+  // images are rendered off-screen (framebuffer objects), which needs a scale
+  if (!mv_->SaveDisplays(base, ext, std::max(scale, 1))) {
+    std::cerr << "[GUIDisplay] Failed to save event " << evtID << std::endl;
+    return false;
+  }
+  ++nRendered_;
+  return true;
+}
+
+int GUIDisplay::RenderEvents(const std::vector<EventRef>& events, const std::string& pattern, int scale)
+{
+  auto start = std::chrono::steady_clock::now();
+  int nFailed = 0;
+  for (std::size_t i = 0; i < events.size(); ++i) {
+    auto evtStart = std::chrono::steady_clock::now();
+    if (!RenderEvent(events[i], pattern, scale)) {
+      ++nFailed;
+      continue;
+    }
+
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - evtStart).count();
+    std::cout << "[GUIDisplay] Rendered event " << events[i].evtID << " (" << i+1 << "/" << events.size()
+              << ") in " << ms << " ms" << std::endl;
+  }
+
+  auto s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "[GUIDisplay] Rendered " << events.size() - nFailed << " events in " << s << " s ("
+            << (s > 0 ? (events.size() - nFailed) / s : 0) << " events/s), " << nFailed << " failed" << std::endl;
+  return nFailed;
+}
+
+void GUIDisplay::OnCutsChanged()
+{
+  auto start = std::chrono::steady_clock::now();
+
+  // re-filter the event already in memory, no re-reading; an event cut
+  // down by the vertex cap is built again for the new cuts
+  const bool rebuild = dataMgr_.GetNOmittedTracks() > 0;
+  if (dataMgr_.SetCuts(kinECutEntry_->GetNumber(), lengthCutEntry_->GetNumber())) {
+    if (rebuild) ShowEvent();
+    else gEve->Redraw3D(kFALSE);
+  }
+  UpdateSummary();
+
+  auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "[GUIDisplay] Cuts applied in " << ms << " ms" << std::endl;
+}
+
+void GUIDisplay::OnQuery()
+{
+  const EventRef before = dataMgr_.GetCurrent();
+  std::string error;
+  if (dataMgr_.SetQuery(queryEntry_->GetText(), error)) {
+    queryStatus_->SetText(Form("%zu of %zu%s events", dataMgr_.GetSelection().size(), dataMgr_.GetNEvents(),
+                               dataMgr_.GetQuery().empty() && !dataMgr_.AllFilesListed() ? "+" : ""));
+    if (dataMgr_.GetCurrent() != before) RequestEvent();
+  } else {
+    queryStatus_->SetText(error.c_str());
+  }
+  queryStatus_->Resize(queryStatus_->GetDefaultWidth(), queryStatus_->GetDefaultHeight());
+  UpdateSummary();
+}
+
+void GUIDisplay::OnGoToEvent()
+{
+  if (!dataMgr_.GoToEvent(gotoEntry_->GetIntNumber())) return;
+  ShowJumpedEvent();
+}
+
+void GUIDisplay::OnSearchAllFiles()
+{
+  if (!dataMgr_.SearchAllFiles(gotoEntry_->GetIntNumber())) return;
+  loadingLabel_->SetText(Form("Searching event %ld...", gotoEntry_->GetIntNumber()));
+  loadingLabel_->Resize(loadingLabel_->GetDefaultWidth(), loadingLabel_->GetDefaultHeight());
+  searchTimer_->Start(100, kFALSE);
+}
+
+void GUIDisplay::OnSearchTick()
+{
+  const bool found = dataMgr_.PollSearch();
+  if (!dataMgr_.IsSearching()) {
+    searchTimer_->Stop();
+    loadingLabel_->SetText("");
+  }
+  if (found) ShowJumpedEvent();
+}
+
+void GUIDisplay::ShowJumpedEvent()
+{
+  // jumping outside of the selection drops the query
+  if (dataMgr_.GetQuery().empty() && queryEntry_->GetText()[0]) {
+    queryEntry_->SetText("");
+    queryStatus_->SetText("All events");
+  }
+  RequestEvent();
+  UpdateSummary();
+}
+
 void GUIDisplay::MakeControlTab()
 {
   std::cout << "[GUIDisplay] Building 'Event Control' tab..." << std::endl;
@@ -152,8 +479,75 @@ void GUIDisplay::MakeControlTab()
   TGLabel *lblNext = new TGLabel(hf, "Next");
   hf->AddFrame(lblNext, new TGLayoutHints(kLHintsCenterY, 0,5,2,2));
 
+  // jump to an event ID
+  gotoEntry_ = new TGNumberEntry(hf, dataMgr_.GetCurrentEvent(), 7, -1,
+                                 TGNumberFormat::kNESInteger, TGNumberFormat::kNEANonNegative);
+  hf->AddFrame(gotoEntry_, new TGLayoutHints(kLHintsCenterY, 15, 2, 2, 2));
+  TGTextButton* gotoBtn = new TGTextButton(hf, "Go");
+  hf->AddFrame(gotoBtn, new TGLayoutHints(kLHintsCenterY, 2, 5, 2, 2));
+  gotoBtn->Connect("Clicked()", "GUIDisplay", this, "OnGoToEvent()");
+  if (dataMgr_.GetNFiles() > 1) {
+    // "Go" only looks in the files indexed so far
+    TGTextButton* searchBtn = new TGTextButton(hf, "Search all files");
+    hf->AddFrame(searchBtn, new TGLayoutHints(kLHintsCenterY, 2, 5, 2, 2));
+    searchBtn->Connect("Clicked()", "GUIDisplay", this, "OnSearchAllFiles()");
+  }
+
+  // shown while an event is decoded in the background
+  loadingLabel_ = new TGLabel(hf, "");
+  hf->AddFrame(loadingLabel_, new TGLayoutHints(kLHintsCenterY, 10, 5, 2, 2));
+
   frm->AddFrame(hf, new TGLayoutHints(kLHintsTop | kLHintsCenterX));
 
+  // selection cuts, applied to secondary tracks
+  TGHorizontalFrame* cutFrame = new TGHorizontalFrame(frm);
+  TGLabel* kinELabel = new TGLabel(cutFrame, "Min. kinE [MeV]:");
+  cutFrame->AddFrame(kinELabel, new TGLayoutHints(kLHintsCenterY, 5, 2, 2, 2));
+  kinECutEntry_ = new TGNumberEntry(cutFrame, dataMgr_.GetKinECut(), 6, -1,
+                                    TGNumberFormat::kNESRealOne, TGNumberFormat::kNEANonNegative,
+                                    TGNumberFormat::kNELLimitMin, 0);
+  cutFrame->AddFrame(kinECutEntry_, new TGLayoutHints(kLHintsCenterY, 2, 10, 2, 2));
+  kinECutEntry_->Connect("ValueSet(Long_t)", "GUIDisplay", this, "OnCutsChanged()");
+
+  TGLabel* lengthLabel = new TGLabel(cutFrame, "Min. length [cm]:");
+  cutFrame->AddFrame(lengthLabel, new TGLayoutHints(kLHintsCenterY, 5, 2, 2, 2));
+  lengthCutEntry_ = new TGNumberEntry(cutFrame, dataMgr_.GetLengthCut(), 6, -1,
+                                      TGNumberFormat::kNESRealOne, TGNumberFormat::kNEANonNegative,
+                                      TGNumberFormat::kNELLimitMin, 0);
+  cutFrame->AddFrame(lengthCutEntry_, new TGLayoutHints(kLHintsCenterY, 2, 5, 2, 2));
+  lengthCutEntry_->Connect("ValueSet(Long_t)", "GUIDisplay", this, "OnCutsChanged()");
+
+  frm->AddFrame(cutFrame, new TGLayoutHints(kLHintsTop | kLHintsCenterX, 5, 5, 5, 5));
+
+  // event selection over the per-event summary, e.g. "nMuons > 0 sort maxMuonE desc"
+  TGHorizontalFrame* queryFrame = new TGHorizontalFrame(frm);
+  TGLabel* queryLabel = new TGLabel(queryFrame, "Query:");
+  queryFrame->AddFrame(queryLabel, new TGLayoutHints(kLHintsCenterY, 5, 2, 2, 2));
+  queryEntry_ = new TGTextEntry(queryFrame, "");
+  queryEntry_->SetWidth(250);
+  queryEntry_->SetToolTipText(("Filter [sort EXPR [desc]] over the columns:\n" + EventQuery::GetHelp()).c_str());
+  queryFrame->AddFrame(queryEntry_, new TGLayoutHints(kLHintsCenterY | kLHintsExpandX, 2, 2, 2, 2));
+  queryEntry_->Connect("ReturnPressed()", "GUIDisplay", this, "OnQuery()");
+  TGTextButton* queryBtn = new TGTextButton(queryFrame, "Select");
+  queryFrame->AddFrame(queryBtn, new TGLayoutHints(kLHintsCenterY, 2, 5, 2, 2));
+  queryBtn->Connect("Clicked()", "GUIDisplay", this, "OnQuery()");
+  frm->AddFrame(queryFrame, new TGLayoutHints(kLHintsTop | kLHintsExpandX, 5, 5, 2, 2));
+
+  queryStatus_ = new TGLabel(frm, "All events");
+  frm->AddFrame(queryStatus_, new TGLayoutHints(kLHintsTop | kLHintsCenterX, 5, 5, 0, 2));
+
+  // detector toggles, a detector geometry is loaded when first checked
+  TGHorizontalFrame* detFrame = new TGHorizontalFrame(frm);
+  const auto& detectors = GeometryManager::GetDetectors();
+  for (std::size_t d = 0; d < detectors.size(); ++d) {
+    TGCheckButton* check = new TGCheckButton(detFrame, detectors[d].name.c_str());
+    check->SetOn(detectorViews_[d].shown);
+    detFrame->AddFrame(check, new TGLayoutHints(kLHintsCenterY, 5, 5, 2, 2));
+    check->Connect("Toggled(Bool_t)", "GUIDisplay", this, "OnDetectorToggled()");
+    detectorViews_[d].button = check;
+  }
+  frm->AddFrame(detFrame, new TGLayoutHints(kLHintsTop | kLHintsCenterX, 5, 5, 5, 5));
+
   // event summary
   summaryView_ = new TGLabel(frm, "");
   frm->AddFrame(summaryView_, new TGLayoutHints(kLHintsExpandX | kLHintsTop, 5, 5, 10, 5));
@@ -171,6 +565,11 @@ void GUIDisplay::MakeControlTab()
   outFrame->AddFrame(saveBtn, new TGLayoutHints(kLHintsCenterY, 2, 5, 2, 2));
   saveBtn->Connect("Clicked()", "GUIDisplay", this, "OnSave()");
 
+  // one tiled image instead of four
+  tiledCheck_ = new TGCheckButton(outFrame, "Tiled");
+  tiledCheck_->SetOn(tiledExport_);
+  outFrame->AddFrame(tiledCheck_, new TGLayoutHints(kLHintsCenterY, 2, 5, 2, 2));
+
   frm->AddFrame(outFrame, new TGLayoutHints(kLHintsCenterX | kLHintsTop, 5, 5, 5, 5));
 
   frm->MapSubwindows();
@@ -183,7 +582,11 @@ void GUIDisplay::MakeControlTab()
 
 void GUIDisplay::UpdateSummary()
 {
-  summaryView_->SetText(dataMgr_.GetSummary().c_str());
+  if (!summaryView_) return;
+  std::string summary = dataMgr_.GetSummary();
+  summary += "\n\nLast timings: " + StageStats::Instance().GetSummary(
+    {"event.read", "event.build", "project.event.zx", "project.event.zy", "event.redraw"});
+  summaryView_->SetText(summary.c_str());
   // resize to fit new text
   summaryView_->Resize(summaryView_->GetDefaultWidth(),summaryView_->GetDefaultHeight());
 }
@@ -0,0 +1,119 @@
+#include "GeometryBudget.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+#include "TBuffer3D.h"
+#include "TEveProjectionBases.h"
+#include "TEveShape.h"
+
+namespace {
+
+    void SetSegments(TEveElement* el, Int_t nSegments)
+    {
+        if (auto shape = dynamic_cast<TEveGeoShape*>(el)) shape->SetNSegments(nSegments);
+        for (auto it = el->BeginChildren(); it != el->EndChildren(); ++it)
+            SetSegments(*it, nSegments);
+    }
+
+    /// Original gentle shape of an element, projected or not
+    TEveGeoShape* GetMasterShape(TEveElement* el)
+    {
+        if (auto projected = dynamic_cast<TEveProjected*>(el))
+            return dynamic_cast<TEveGeoShape*>(projected->GetProjectable());
+        return dynamic_cast<TEveGeoShape*>(el);
+    }
+}
+
+Long64_t GeometryBudget::CountTriangles(TEveGeoShape* shape)
+{
+    std::unique_ptr<TBuffer3D> buffer(shape->MakeBuffer3D());
+    if (!buffer) return 0;
+
+    // polygons are stored as: color, number of segments, segments...
+    Long64_t triangles = 0;
+    const Int_t* pols = buffer->fPols;
+    for (UInt_t p = 0, j = 0; p < buffer->NbPols(); ++p) {
+        const Int_t nSegs = pols[j + 1];
+        triangles += std::max(nSegs - 2, 0);
+        j += nSegs + 2;
+    }
+    return triangles;
+}
+
+void GeometryBudget::Add(TEveElement* gentle, Int_t nSegments)
+{
+    if (nSegments > 0) SetSegments(gentle, nSegments);
+
+    std::vector<TEveElement*> stack = {gentle};
+    while (!stack.empty()) {
+        TEveElement* el = stack.back();
+        stack.pop_back();
+        auto shape = dynamic_cast<TEveGeoShape*>(el);
+        if (shape && shape->GetRnrSelf()) triangles_[shape] = CountTriangles(shape);
+        for (auto it = el->BeginChildren(); it != el->EndChildren(); ++it)
+            stack.push_back(*it);
+    }
+}
+
+void GeometryBudget::AddShape(TEveElement* el, int detector, std::vector<Shape>& shapes) const
+{
+    auto it = triangles_.find(GetMasterShape(el));
+    auto shape = dynamic_cast<TEveShape*>(el);
+    if (it == triangles_.end() || !shape) return;
+
+    if (!shape->GetBBox()) shape->ComputeBBox();
+    const Float_t* bb = shape->GetBBox();
+    const Float_t size = bb ? std::max({bb[1] - bb[0], bb[3] - bb[2], bb[5] - bb[4]}) : 0.f;
+    shapes.push_back({el, size, it->second, detector});
+}
+
+void GeometryBudget::Collect(TEveElement* el, int detector, std::vector<Shape>& shapes) const
+{
+    AddShape(el, detector, shapes);
+    for (auto c = el->BeginChildren(); c != el->EndChildren(); ++c)
+        Collect(*c, detector, shapes);
+}
+
+Long64_t GeometryBudget::Apply(TEveElement* top, Long64_t budget, const std::string& viewer)
+{
+    // the children of the top element are the detectors
+    std::vector<Shape> shapes;
+    std::vector<std::string> detectors = {top->GetElementName()};
+    AddShape(top, 0, shapes);
+    for (auto it = top->BeginChildren(); it != top->EndChildren(); ++it) {
+        if (!(*it)->GetRnrChildren()) continue;
+        detectors.push_back((*it)->GetElementName());
+        Collect(*it, detectors.size() - 1, shapes);
+    }
+
+    // keep the largest shapes first
+    std::stable_sort(shapes.begin(), shapes.end(),
+                     [](const Shape& a, const Shape& b) { return a.size > b.size; });
+
+    struct Count { int shapes = 0, drawn = 0; Long64_t triangles = 0; };
+    std::vector<Count> counts(detectors.size());
+    Long64_t total = 0;
+    for (const Shape& s : shapes) {
+        const bool draw = budget <= 0 || total + s.triangles <= budget;
+        s.element->SetRnrSelf(draw);
+        Count& c = counts[s.detector];
+        ++c.shapes;
+        if (!draw) continue;
+        ++c.drawn;
+        c.triangles += s.triangles;
+        total += s.triangles;
+    }
+
+    std::cout << "[GeometryBudget] " << viewer << ": " << total << " triangles";
+    if (budget > 0) std::cout << " (budget " << budget << ")";
+    std::cout << std::endl;
+    for (std::size_t d = 0; d < detectors.size(); ++d) {
+        if (counts[d].shapes == 0) continue;
+        std::cout << "[GeometryBudget]   " << detectors[d] << ": "
+                  << counts[d].drawn << "/" << counts[d].shapes << " shapes, "
+                  << counts[d].triangles << " triangles" << std::endl;
+    }
+    return total;
+}
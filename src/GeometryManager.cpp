@@ -1,8 +1,12 @@
 #include "GeometryManager.hh"
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
+#include <unordered_map>
 
 #include "TFile.h"
+#include "TGeoBBox.h"
 #include "TGeoManager.h"
 #include "TGeoNode.h"
 #include "TGeoVolume.h"
@@ -10,8 +14,22 @@
 #include "TEveManager.h"
 #include "TEveEventManager.h"
 #include "TEveGeoShapeExtract.h"
+#include "TEveElement.h"
+#include "TMD5.h"
+#include "TString.h"
+#include "TSystem.h"
+
+#include "CacheDirectory.hh"
+#include "StageTimer.hh"
+
+#ifndef FPFDISPLAY_CONFIG_DIR
+#define FPFDISPLAY_CONFIG_DIR "config"
+#endif
+
+GeometryManager::GeometryManager()
+    : styleFile_(FPFDISPLAY_CONFIG_DIR "/geometry_style.txt")
+{}
 
-GeometryManager::GeometryManager() = default;
 GeometryManager::~GeometryManager() = default;
 
 void GeometryManager::PrintHierarchyTree(TGeoNode* node,
@@ -36,15 +54,103 @@ void GeometryManager::PrintHierarchyTree(TGeoNode* node,
 void GeometryManager::LoadGDML(const std::string& gdmlFile)
 {
     std::cout << "[GeometryManager] Loading GDML: " << gdmlFile << std::endl;
+    if (gSystem->AccessPathName(gdmlFile.c_str()))
+        throw std::runtime_error("GDML file not found: " + gdmlFile);
+
+    gdmlFile_ = gdmlFile;
+    hallNode_ = nullptr;
+    styled_ = false;
+    detectorNodes_.clear();
+    LoadStyle();
+
+    // The gentle extracts only depend on the GDML contents and styling options,
+    // so they are cached under that key and reused without even importing the GDML
+    StageTimer timer("geometry.key");
+    gentleKey_ = GentleKey();
+}
+
+std::string GeometryManager::GentlePath(const std::string& detector) const
+{
+    std::string cacheDir = GetCacheDirectory();
+    if (cacheDir.empty()) cacheDir = gSystem->TempDirectory();
+    return cacheDir + "/gentle_" + gentleKey_ + "_" + detector + ".root";
+}
+
+const std::vector<GeometryManager::Detector>& GeometryManager::GetDetectors()
+{
+    // "Other" collects the daughters of the hall not listed before it
+    static const std::vector<Detector> detectors = {
+        {"FLArE",    "FLArETPCPhysical"},
+        {"FASER2",   "FASER2Physical"},
+        {"FASERnu2", "FASERnu2Physical"},
+        {"FORMOSA",  "FORMOSAPhysical"},
+        {"BabyMIND", "BabyMINDPhysical"},
+        {"Other",    ""},
+    };
+    return detectors;
+}
+
+bool GeometryManager::IsDetectorNode(const std::string& detector, TGeoNode* node)
+{
+    const std::string name = node->GetName();
+    for (const Detector& d : GetDetectors()) {
+        if (d.physical.empty()) return detector == d.name;
+        if (name == d.physical) return detector == d.name;
+    }
+    return false;
+}
+
+void GeometryManager::LoadStyle()
+{
+    style_ = GeometryStyle();
+
+    // hall and detector envelopes are always see-through
+    style_.AddRule({"*", 0, 0, -1, 100});
+    style_.AddRule({"*", 1, 1, -1, 90});
+
+    // skip further color/transparency changes
+    if (leaveDefault_) return;
+
+    if (styleFile_.empty()) return;
+    std::cout << "[GeometryManager] Geometry style: " << styleFile_ << std::endl;
+    if (!style_.Load(styleFile_))
+        std::cerr << "[GeometryManager] Volumes without a valid style rule keep their GDML colors" << std::endl;
+}
+
+std::string GeometryManager::GentleKey() const
+{
+    // bump when the extraction or styling code changes
+    const int extractVersion = 4;
+
+    std::unique_ptr<TMD5> gdmlSum(TMD5::FileChecksum(gdmlFile_.c_str()));
+    if (!gdmlSum)
+        throw std::runtime_error("Failed to read GDML: " + gdmlFile_);
+
+    std::string options = Form("v%d;lod=%g,%d,%d,%d;", extractVersion, lod_.minSize, lod_.mergeRepeated,
+                               lod_.nSegments, lod_.maxDepth) + style_.GetKey();
+
+    TMD5 key;
+    key.Update((const UChar_t*) gdmlSum->AsString(), 32);
+    key.Update((const UChar_t*) options.data(), options.size());
+    key.Final();
+    return key.AsString();
+}
+
+void GeometryManager::ImportGDML()
+{
+    if (hallNode_) return;
+
+    StageTimer timer("geometry.import");
+    std::cout << "[GeometryManager] Importing GDML: " << gdmlFile_ << std::endl;
     if (gGeoManager) {
         delete gGeoManager;
         gGeoManager = nullptr;
     }
 
     // import GDML into gGeoManager
-    TGeoManager::Import(gdmlFile.c_str());
+    TGeoManager::Import(gdmlFile_.c_str());
     if (!gGeoManager)
-        throw std::runtime_error("Failed to import GDML: " + gdmlFile);
+        throw std::runtime_error("Failed to import GDML: " + gdmlFile_);
 
     TGeoNode* world = gGeoManager->GetTopNode();
     if (!world)
@@ -68,184 +174,150 @@ void GeometryManager::LoadGDML(const std::string& gdmlFile)
     for (int i = 0; i < hallNode_->GetNdaughters(); ++i) {
         detectorNodes_.push_back(hallNode_->GetDaughter(i));
     }
-
-    // extract gentle geometry: forced to do this as native TEveGeo(Top)Nodes
-    // are not projectable in the viewers...
-    gentleGeoFile_ = gdmlFile.substr(0, gdmlFile.size() - 5) + "_gentle.root";
-    ExtractGentleGeometry();
 }
 
-void GeometryManager::ExtractGentleGeometry()
+void GeometryManager::ExtractGentleGeometry(const std::string& detector, const std::string& file)
 {
-    std::cout << "[GeometryManager] Extracting gentle geometry to " << gentleGeoFile_ << "..." << std::endl;
-    TEveManager *locEve = TEveManager::Create();
+    std::cout << "[GeometryManager] Extracting gentle geometry of " << detector << " to " << file << "..." << std::endl;
+    StageTimer timer("geometry.extract");
+    TEveManager::Create();
 
-    // TODO/FIXME: build this list better/manually looping detectorNodes_?
-    // make each detector node into its top node?
+    // extract gentle geometry: forced to do this as native TEveGeo(Top)Nodes
+    // are not projectable in the viewers...
     // see https://root-forum.cern.ch/t/axes-dont-show-up-in-the-projection-of-a-imported-gdml-geometry-in-eve/40484/3
+    // The hall is kept as the top node so that the extract has global transformations
     TEveGeoTopNode* eveTopNode = new TEveGeoTopNode(gGeoManager, hallNode_);
     eveTopNode->SetVisLevel(4);
-    eveTopNode->GetNode()->GetVolume()->SetTransparency(100); // hall 100% transparent 
-    for (int i = 0; i < eveTopNode->GetNode()->GetNdaughters(); ++i) {
-
-        eveTopNode->GetNode()->GetDaughter(i)->GetVolume()->SetTransparency(90);  // detector envelopes 100% transparent
-
-        // skip further color/transparency changes
-        if( leaveDefault_ ) continue;
-
-        // descend into specific sub-volumes
-        auto current_node = eveTopNode->GetNode()->GetDaughter(i);
-        std::string namePV(current_node->GetName());
-        //std::cout << namePV << std::endl;
-
-        // TODO/FIXME: make the below better (fix geometry in FPFSim?)
-        // this allows to set properties to each node/subnode individually
-
-        // ***** FLARE VOLUMES ******
-        if (namePV == "FLArETPCPhysical"){
-
-            for(int j = 0; j < current_node->GetNdaughters(); ++j){
-
-                std::string flarePV(current_node->GetDaughter(j)->GetName());
-                //std::cout << flarePV << std::endl;
-
-                if(flarePV == "LArPhysical"){
-                    auto tpc = current_node->GetDaughter(j);
-                    tpc->GetVolume()->SetTransparency(90); //make it transparent
-                    // go down further and make lar modules light blue
-                    for(int k = 0; k < tpc->GetNdaughters(); ++k){
-                        tpc->GetDaughter(k)->GetVolume()->SetLineColor(kCyan-10);
-                        tpc->GetDaughter(k)->GetVolume()->SetTransparency(90);
-
-                        for(int kk=0; kk<tpc->GetDaughter(k)->GetNdaughters(); ++kk){
-                            tpc->GetDaughter(k)->GetDaughter(kk)->GetVolume()->SetLineColor(kCyan-10);
-                            tpc->GetDaughter(k)->GetDaughter(kk)->GetVolume()->SetTransparency(90);
-
-                        }   
-                    }    
-                }
-                else if( flarePV == "CryostatPhysical") {
-                    current_node->GetDaughter(j)->GetVolume()->SetTransparency(70); //make it transparent
-                }                
-            }
-        }
-
-        // ***** BABYMIND VOLUMES ******
-        else if (namePV == "BabyMINDPhysical"){
-
-            for(int j = 0; j < current_node->GetNdaughters(); ++j){
-    
-                std::string bmindPV(current_node->GetDaughter(j)->GetName());
-                //std::cout << bmindPV << std::endl;
-    
-                if(bmindPV.find("Magnet") != std::string::npos) {
-                    current_node->GetDaughter(j)->GetVolume()->SetTransparency(30);
-                }
-                /*else{
-                    // go down further into detector modules
-                    auto detmod = current_node->GetDaughter(j);
-                    //std::cout << detmod->GetName() << std::endl;
-                    for(int k = 0; k < detmod->GetNdaughters(); ++k){
-                        detmod->GetDaughter(k)->GetVolume()->SetTransparency(50);
-                        for(int kk=0; kk<detmod->GetDaughter(k)->GetNdaughters(); ++kk){
-                            detmod->GetDaughter(k)->GetDaughter(kk)->GetVolume()->SetTransparency(0);
-                        }   
-                    }    
-                } */     
-            }
-        }
+    if (!styled_) {
+        StageTimer styleTimer("geometry.style");
+        style_.Apply(hallNode_);
+        styled_ = true;
+    }
 
-        // ***** FORMOSA VOLUMES ******
-        else if (namePV == "FORMOSAPhysical"){
-
-            for(int j = 0; j < current_node->GetNdaughters(); ++j){
-                auto mod = current_node->GetDaughter(j);
-
-                // go down further into modules
-                for(int k = 0; k < mod->GetNdaughters(); ++k){
-
-                    std::string formosaPV(mod->GetDaughter(k)->GetName());
-                    if(formosaPV.find("PMT") != std::string::npos) {
-                        // FIXME: doesn't work because material is AIR... --> something else ovverides it?
-                        mod->GetDaughter(k)->GetVolume()->SetTransparency(10);
-                    }
-                    /*else{
-                        std::cout << "hey" << std::endl;
-                        mod->GetDaughter(k)->GetVolume()->SetTransparency(80);
-                    } */
-                }        
-            }
-        }
+    // only the TEveGeoNodes added below are extracted
+    for (TGeoNode* node : detectorNodes_) {
+        if (!IsDetectorNode(detector, node)) continue;
+        auto element = new TEveGeoNode(node);
+        eveTopNode->AddElement(element);
+
+        ExtractStats stats;
+        stats.extracted = 1;
+        ExpandNode(element, 1, stats);
+        std::cout << "[GeometryManager]   " << node->GetName() << ": " << stats.extracted << " nodes extracted, "
+                  << stats.culled << " culled, " << stats.merged << " merged" << std::endl;
+    }
 
-        // ***** FASER2 VOLUMES ******
-        else if (namePV == "FASER2Physical"){
+    // composite shapes are tessellated when extracted
+    if (lod_.nSegments > 0) gGeoManager->SetNsegments(lod_.nSegments);
+
+    // write under a temporary name, so that an interrupted extraction
+    // never leaves a truncated file behind under the cache key
+    std::string tmpFile = file + Form(".tmp%d.root", gSystem->GetPid());
+    eveTopNode->SaveExtract(tmpFile.c_str(), "Gentle", kFALSE);
+    eveTopNode->Destroy();
+    if (gSystem->Rename(tmpFile.c_str(), file.c_str()) != 0) {
+        gSystem->Unlink(tmpFile.c_str());
+        throw std::runtime_error("Failed to write gentle geometry: " + file);
+    }
+}
 
-            for(int j = 0; j < current_node->GetNdaughters(); ++j){
+void GeometryManager::ExpandNode(TEveGeoNode* parent, int depth, ExtractStats& stats)
+{
+    if (lod_.maxDepth > 0 && depth >= lod_.maxDepth) return;
+    TGeoNode* node = parent->GetNode();
+
+    // daughter volumes placed often enough to be merged into this one
+    std::unordered_map<TGeoVolume*, int> placements;
+    if (lod_.mergeRepeated > 1) {
+        for (int i = 0; i < node->GetNdaughters(); ++i)
+            ++placements[node->GetDaughter(i)->GetVolume()];
+    }
 
-                auto element = current_node->GetDaughter(j);
-                std::string faser2PV(element->GetName());
+    TGeoVolume* merged = nullptr;
+    for (int i = 0; i < node->GetNdaughters(); ++i) {
+        TGeoNode* daughter = node->GetDaughter(i);
+        TGeoVolume* volume = daughter->GetVolume();
 
-                if(faser2PV.find("Yoke") != std::string::npos) {
-                    element->GetVolume()->SetTransparency(60);
-                }
-                else if(faser2PV.find("Cal") != std::string::npos){
-                    element->GetVolume()->SetTransparency(60);
-                }
-                else if(faser2PV.find("IronWall") != std::string::npos){
-                    element->GetVolume()->SetTransparency(60);
-                }              
-            }
+        if (lod_.mergeRepeated > 1 && placements[volume] >= lod_.mergeRepeated) {
+            if (!merged || placements[volume] > placements[merged]) merged = volume;
+            ++stats.merged;
+            continue;
         }
 
-        // ***** FASERnu2 VOLUMES ******
-        else if (namePV == "FASERnu2Physical"){
-
-            for(int j = 0; j < current_node->GetNdaughters(); ++j){
-                auto element = current_node->GetDaughter(j);
-
-                for(int k = 0; k < element->GetNdaughters(); ++k){
-                    std::string fasernuPV(element->GetDaughter(k)->GetName());
-
-                    if(fasernuPV.find("tungsten") != std::string::npos) {
-                        element->GetDaughter(k)->GetVolume()->SetTransparency(60);
-                    }
-                }              
-            }
+        auto box = dynamic_cast<TGeoBBox*>(volume->GetShape());
+        if (lod_.minSize > 0 && box && 2 * std::max({box->GetDX(), box->GetDY(), box->GetDZ()}) < lod_.minSize) {
+            ++stats.culled;
+            continue;
         }
 
+        auto element = new TEveGeoNode(daughter);
+        parent->AddElement(element);
+        ++stats.extracted;
+        ExpandNode(element, depth + 1, stats);
     }
 
-    locEve->AddElement(eveTopNode);
-    
-    eveTopNode->ExpandIntoListTreesRecursively();
-    eveTopNode->SaveExtract(gentleGeoFile_.c_str(), "Gentle", kFALSE);
-
-    locEve->GetCurrentEvent()->DestroyElements();
+    // the mother stands for the merged daughters: draw it with their style
+    if (merged) {
+        node->GetVolume()->SetLineColor(merged->GetLineColor());
+        node->GetVolume()->SetTransparency(merged->GetTransparency());
+    }
 }
 
-TEveGeoShape* GeometryManager::ImportGentleGeometry()
+TEveElementList* GeometryManager::ImportGentleGeometry(const std::string& detector)
 {
-    std::cout << "[GeometryManager] Re-importing gentle geometry from " << gentleGeoFile_ << "..." << std::endl;
+    const std::string file = GentlePath(detector);
+    if (gSystem->AccessPathName(file.c_str())) {
+        ImportGDML();
+        ExtractGentleGeometry(detector, file);
+    }
+    std::cout << "[GeometryManager] Importing gentle geometry of " << detector << " from " << file << "..." << std::endl;
+    StageTimer timer("geometry.load");
+
+    auto geom = TFile::Open(file.c_str());
+    auto gse = (geom && !geom->IsZombie()) ? (TEveGeoShapeExtract*) geom->Get("Gentle") : nullptr;
+
+    // unreadable cache entry: extract it again
+    if (!gse) {
+        std::cerr << "[GeometryManager] Invalid gentle geometry " << file << ", extracting it again" << std::endl;
+        delete geom;
+        gSystem->Unlink(file.c_str());
+        ImportGDML();
+        ExtractGentleGeometry(detector, file);
+
+        geom = TFile::Open(file.c_str());
+        gse = geom ? (TEveGeoShapeExtract*) geom->Get("Gentle") : nullptr;
+        if (!gse)
+            throw std::runtime_error("Failed to import gentle geometry: " + file);
+    }
 
-    auto geom = TFile::Open(gentleGeoFile_.c_str());
-    if (!geom)  
-        throw std::runtime_error("Failed to import gentle geometry: " + gentleGeoFile_);
+    auto hall = TEveGeoShape::ImportShapeExtract(gse, 0);
+    delete geom;
 
-    auto gse = (TEveGeoShapeExtract*) geom->Get("Gentle");
-    auto gentle = TEveGeoShape::ImportShapeExtract(gse, 0);
-    geom->Close();
+    // keep the detector volumes only: the hall is invisible, and the
+    // transformations of the extract are global
+    auto gentle = new TEveElementList(detector.c_str());
+    std::vector<TEveElement*> volumes(hall->BeginChildren(), hall->EndChildren());
+    for (TEveElement* volume : volumes) gentle->AddElement(volume);
+    hall->Destroy();
 
+    if (volumes.empty()) {
+        std::cout << "[GeometryManager] No " << detector << " volumes in " << gdmlFile_ << std::endl;
+        gentle->Destroy();
+        return nullptr;
+    }
     return gentle;
 }
 
-TEveGeoTopNode* GeometryManager::GetTopNode() const
+TEveGeoTopNode* GeometryManager::GetTopNode()
 {
+    ImportGDML();
     auto topNode = new TEveGeoTopNode(gGeoManager, hallNode_);
     topNode->SetVisLevel(6);
     return topNode;
 }
 
-const std::vector<TGeoNode*>& GeometryManager::GetDetectorNodes() const
+const std::vector<TGeoNode*>& GeometryManager::GetDetectorNodes()
 {
+    ImportGDML();
     return detectorNodes_;
 }
@@ -0,0 +1,196 @@
+#include "ImageWriter.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <set>
+
+#include <png.h>
+
+#include "TGLCamera.h"
+#include "TGLUtil.h"
+#include "TGLViewer.h"
+#include "TImage.h"
+#include "TMath.h"
+
+namespace {
+    std::mutex instancesMutex;
+    std::set<ImageWriter*> instances;
+}
+
+ImageWriter::ImageWriter()
+{
+    static const bool registered = (std::atexit(&ImageWriter::WaitAll) == 0);
+    (void) registered;
+
+    std::lock_guard<std::mutex> lock(instancesMutex);
+    instances.insert(this);
+}
+
+ImageWriter::~ImageWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(instancesMutex);
+        instances.erase(this);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void ImageWriter::WaitAll()
+{
+    std::lock_guard<std::mutex> lock(instancesMutex);
+    for (ImageWriter* writer : instances) writer->Wait();
+}
+
+bool ImageWriter::Grab(TGLViewer* viewer, int scale, const std::string& name, Image& image)
+{
+    TImage* picture = nullptr;
+    if (scale > 0) {
+        const TGLRect& vp = viewer->CurrentCamera().RefViewport();
+        picture = viewer->GetPictureUsingFBO(TMath::Nint(scale * vp.Width()), TMath::Nint(scale * vp.Height()), scale);
+    } else {
+        picture = viewer->GetPictureUsingBB();
+    }
+    std::unique_ptr<TImage> owner(picture);
+    if (!picture || !picture->IsValid()) {
+        std::cerr << "[ImageWriter] Failed to grab " << name << std::endl;
+        return false;
+    }
+
+    const UInt_t* argb = picture->GetArgbArray();
+    if (!argb) return false;
+    image.name = name;
+    image.width = picture->GetWidth();
+    image.height = picture->GetHeight();
+    image.argb.assign(argb, argb + std::size_t(image.width) * image.height);
+    return true;
+}
+
+void ImageWriter::Write(std::vector<Image> images)
+{
+    auto shared = std::make_shared<std::vector<Image>>(std::move(images));
+    Push([shared]() {
+        for (const Image& image : *shared) WritePNG(image);
+    });
+}
+
+void ImageWriter::WriteTiled(std::vector<Image> images, int columns, const std::string& name)
+{
+    auto shared = std::make_shared<std::vector<Image>>(std::move(images));
+    Push([shared, columns, name]() {
+        WritePNG(Tile(*shared, columns, name));
+    });
+}
+
+void ImageWriter::Push(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+        if (!thread_.joinable()) thread_ = std::thread(&ImageWriter::Loop, this);
+    }
+    cv_.notify_all();
+}
+
+void ImageWriter::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return jobs_.empty() && running_ == 0; });
+}
+
+void ImageWriter::Loop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+        if (jobs_.empty()) return; // stopping, nothing left to write
+
+        std::function<void()> job = std::move(jobs_.front());
+        jobs_.pop_front();
+        ++running_;
+        lock.unlock();
+        job();
+        lock.lock();
+        --running_;
+        cv_.notify_all();
+    }
+}
+
+ImageWriter::Image ImageWriter::Tile(const std::vector<Image>& images, int columns, const std::string& name)
+{
+    Image tiled;
+    tiled.name = name;
+    if (images.empty()) return tiled;
+
+    columns = std::max(1, std::min<int>(columns, images.size()));
+    const int rows = (images.size() + columns - 1) / columns;
+    UInt_t cellW = 0, cellH = 0;
+    for (const Image& image : images) {
+        cellW = std::max(cellW, image.width);
+        cellH = std::max(cellH, image.height);
+    }
+
+    tiled.width = cellW * columns;
+    tiled.height = cellH * rows;
+    tiled.argb.assign(std::size_t(tiled.width) * tiled.height, 0xff000000);
+    for (std::size_t i = 0; i < images.size(); ++i) {
+        const Image& image = images[i];
+        const std::size_t x0 = (i % columns) * cellW, y0 = (i / columns) * cellH;
+        for (UInt_t y = 0; y < image.height; ++y) {
+            std::copy_n(image.argb.begin() + std::size_t(y) * image.width, image.width,
+                        tiled.argb.begin() + (y0 + y) * tiled.width + x0);
+        }
+    }
+    return tiled;
+}
+
+bool ImageWriter::WritePNG(const Image& image)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    FILE* file = std::fopen(image.name.c_str(), "wb");
+    if (!file) {
+        std::cerr << "[ImageWriter] Cannot open " << image.name << std::endl;
+        return false;
+    }
+
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png ? png_create_info_struct(png) : nullptr;
+    std::vector<png_byte> row(3 * image.width);
+    if (!info || setjmp(png_jmpbuf(png))) {
+        png_destroy_write_struct(&png, info ? &info : nullptr);
+        std::fclose(file);
+        std::cerr << "[ImageWriter] Failed to write " << image.name << std::endl;
+        return false;
+    }
+
+    png_init_io(png, file);
+    png_set_IHDR(png, info, image.width, image.height, 8, PNG_COLOR_TYPE_RGB,
+                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
+    for (UInt_t y = 0; y < image.height; ++y) {
+        const UInt_t* in = &image.argb[std::size_t(y) * image.width];
+        for (UInt_t x = 0; x < image.width; ++x) {
+            row[3*x]     = (in[x] >> 16) & 0xff;
+            row[3*x + 1] = (in[x] >> 8) & 0xff;
+            row[3*x + 2] = in[x] & 0xff;
+        }
+        png_write_row(png, row.data());
+    }
+    png_write_end(png, nullptr);
+    png_destroy_write_struct(&png, &info);
+    std::fclose(file);
+
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[ImageWriter] Wrote " << image.name << " (" << image.width << "x" << image.height
+              << ") in " << ms << " ms" << std::endl;
+    return true;
+}
@@ -1,7 +1,11 @@
 #include <iostream>
+#include <map>
+#include <set>
 #include <string>
 
 #include "MultiView.hh"
+#include "StageTimer.hh"
+#include "TrackBatch.hh"
 
 #include "TEveManager.h"
 #include "TEveBrowser.h"
@@ -89,57 +93,135 @@ void MultiView::SetDepth(Float_t d)
 }
 
 // ____________________________________________________________________________
-void MultiView::ImportGeomZX(TEveElement* el)
+TEveElement* MultiView::ImportGeomZX(TEveElement* el, TEveElement* parent)
 {
-   fZXMgr->ImportElements(el, fZXGeomScene);
+   StageTimer timer("project.geometry.zx");
+   return fZXMgr->ImportElements(el, parent ? parent : fZXGeomScene);
 }
 
 // ____________________________________________________________________________
-void MultiView::ImportGeomZY(TEveElement* el)
+TEveElement* MultiView::ImportGeomZY(TEveElement* el, TEveElement* parent)
 {
-   fZYMgr->ImportElements(el, fZYGeomScene);
+   StageTimer timer("project.geometry.zy");
+   return fZYMgr->ImportElements(el, parent ? parent : fZYGeomScene);
 }
 
 // ____________________________________________________________________________
-void MultiView::ImportEventZX(TEveElement* el)
+void MultiView::UpdateEventZX(TEveElement* el)
 {
-   fZXMgr->ImportElements(el, fZXEventScene);
+   StageTimer timer("project.event.zx");
+   UpdateEvent(fZXMgr, fZXEventScene, el);
 }
 
 // ____________________________________________________________________________
-void MultiView::ImportEventZY(TEveElement* el)
+void MultiView::UpdateEventZY(TEveElement* el)
 {
-   fZYMgr->ImportElements(el, fZYEventScene);
+   StageTimer timer("project.event.zy");
+   UpdateEvent(fZYMgr, fZYEventScene, el);
 }
 
 // ____________________________________________________________________________
-void MultiView::DestroyEventZX()
+// The projections of `el` already in the scene are kept and re-projected in
+// place, so that changing event does not allocate new projected elements.
+void MultiView::UpdateEvent(TEveProjectionManager* mgr, TEveScene* scene, TEveElement* el)
 {
-   fZXEventScene->DestroyElements();
+   // anything else in the scene is from another event top
+   TEveElement* proj = nullptr;
+   std::vector<TEveElement*> stale;
+   for (auto it = scene->BeginChildren(); it != scene->EndChildren(); ++it) {
+      auto p = dynamic_cast<TEveProjected*>(*it);
+      if (!proj && p && dynamic_cast<TEveElement*>(p->GetProjectable()) == el) proj = *it;
+      else stale.push_back(*it);
+   }
+   for (TEveElement* s : stale) scene->RemoveElement(s);
+
+   if (!proj) {
+      mgr->ImportElements(el, scene);
+      return;
+   }
+   Reproject(proj);
+   SyncProjected(mgr, el, proj);
 }
 
 // ____________________________________________________________________________
-void MultiView::DestroyEventZY()
+// The projection is the same as when `proj` was last projected: a track
+// batch filled in chunks only projects the tracks appended since.
+void MultiView::Reproject(TEveElement* proj)
 {
-   fZYEventScene->DestroyElements();
+   if (auto batch = dynamic_cast<TrackBatchProjected*>(proj)) batch->ProjectAppended();
+   else dynamic_cast<TEveProjected*>(proj)->UpdateProjection();
 }
 
 // ____________________________________________________________________________
-void MultiView::SaveDisplays(std::string base, std::string ext, int scale)
+// Bring the projected children of `proj` in line with the children of `el`:
+// projections of removed children are dropped, kept ones re-projected and
+// only the new children imported.
+void MultiView::SyncProjected(TEveProjectionManager* mgr, TEveElement* el, TEveElement* proj)
+{
+   std::set<TEveElement*> children(el->BeginChildren(), el->EndChildren());
+   std::map<TEveElement*, TEveElement*> projected; // child of el -> its projection
+   std::vector<TEveElement*> stale;
+   for (auto it = proj->BeginChildren(); it != proj->EndChildren(); ++it) {
+      // non-projectable elements are imported as plain lists, which can
+      // not be traced back to their original: import those again
+      auto p = dynamic_cast<TEveProjected*>(*it);
+      auto orig = p ? dynamic_cast<TEveElement*>(p->GetProjectable()) : nullptr;
+      if (orig && children.count(orig) && !projected.count(orig)) projected[orig] = *it;
+      else stale.push_back(*it);
+   }
+   for (TEveElement* s : stale) proj->RemoveElement(s);
+
+   for (auto it = el->BeginChildren(); it != el->EndChildren(); ++it) {
+      auto found = projected.find(*it);
+      if (found == projected.end()) {
+         mgr->SubImportElements(*it, proj);
+         continue;
+      }
+
+      TEveElement* child = found->second;
+      Reproject(child);
+      child->SetRnrSelf((*it)->GetRnrSelf());
+      child->SetRnrChildren((*it)->GetRnrChildren());
+      child->ElementChanged(kFALSE);
+      SyncProjected(mgr, *it, child);
+   }
+}
+
+// ____________________________________________________________________________
+bool MultiView::SaveDisplays(std::string base, std::string ext, int scale)
 {
    std::string name3D = base + "_mv3D" + ext;
    std::string nameZX = base + "_mvZX" + ext;
    std::string nameZY = base + "_mvZY" + ext;
+   bool ok = true;
 
    std::cout << "[MultiView] Saving 3D to " << name3D << std::endl;
-   if(scale>0) f3DView->GetGLViewer()->SavePictureScale(name3D.c_str(), scale);
-   else f3DView->GetGLViewer()->SavePicture(name3D.c_str());
+   if(scale>0) ok &= f3DView->GetGLViewer()->SavePictureScale(name3D.c_str(), scale);
+   else ok &= f3DView->GetGLViewer()->SavePicture(name3D.c_str());
    
    std::cout << "[MultiView] Saving ZX to " << nameZX << std::endl; 
-   if(scale>0) fZXView->GetGLViewer()->SavePictureScale(nameZX.c_str(), scale);
-   else fZXView->GetGLViewer()->SavePicture(nameZX.c_str());
+   if(scale>0) ok &= fZXView->GetGLViewer()->SavePictureScale(nameZX.c_str(), scale);
+   else ok &= fZXView->GetGLViewer()->SavePicture(nameZX.c_str());
    
    std::cout << "[MultiView] Saving ZY to " << nameZY << std::endl; 
-   if(scale>0) fZYView->GetGLViewer()->SavePictureScale(nameZY.c_str(), scale);
-   else fZYView->GetGLViewer()->SavePicture(nameZY.c_str());
+   if(scale>0) ok &= fZYView->GetGLViewer()->SavePictureScale(nameZY.c_str(), scale);
+   else ok &= fZYView->GetGLViewer()->SavePicture(nameZY.c_str());
+
+   return ok;
+}
+
+// ____________________________________________________________________________
+bool MultiView::GrabDisplays(std::string base, std::string ext, int scale, std::vector<ImageWriter::Image>& images)
+{
+   bool ok = true;
+   std::pair<TEveViewer*, std::string> views[] = {
+      {f3DView, base + "_mv3D" + ext},
+      {fZXView, base + "_mvZX" + ext},
+      {fZYView, base + "_mvZY" + ext},
+   };
+   for (auto& view : views) {
+      images.emplace_back();
+      ok &= ImageWriter::Grab(view.first->GetGLViewer(), scale, view.second, images.back());
+   }
+   return ok;
 }
@@ -0,0 +1,253 @@
+#include "RenderPool.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+    /// Work queue shared by all processes
+    struct Queue {
+        std::atomic<int64_t> next;
+    };
+    static_assert(std::atomic<int64_t>::is_always_lock_free, "the queue needs a lock-free counter");
+
+    Queue* queue = nullptr;
+
+    typedef std::chrono::steady_clock Clock;
+
+    double Seconds(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration<double>(to - from).count();
+    }
+}
+
+RenderPool::RenderPool(int nWorkers, int chunkSize)
+    : nWorkers_(std::max(nWorkers, 1)), chunkSize_(std::max(chunkSize, 1))
+{}
+
+void RenderPool::Work(int fd, const std::vector<int>& events, const Setup_t& setup, const Render_t& render)
+{
+    auto send = [fd, &events](int type, int64_t i, float ms) {
+        Message m{type, i >= 0 ? events[i] : -1, int(i), ms};
+        while (write(fd, &m, sizeof(m)) < 0 && errno == EINTR) {}
+    };
+
+    auto start = Clock::now();
+    bool ready = false;
+    try {
+        ready = setup();
+    } catch (const std::exception& e) {
+        std::cerr << "[RenderPool] Worker " << getpid() << " setup failed: " << e.what() << std::endl;
+    }
+    if (!ready) {
+        send(Message::kSetupFailed, -1, 0);
+        _exit(3);
+    }
+    send(Message::kReady, -1, 1e3 * Seconds(start, Clock::now()));
+
+    const int64_t n = events.size();
+    for (int64_t first; (first = queue->next.fetch_add(chunkSize_)) < n; ) {
+        for (int64_t i = first; i < std::min(first + chunkSize_, n); ++i) {
+            send(Message::kStart, i, 0);
+            auto evtStart = Clock::now();
+            bool ok = false;
+            try {
+                ok = render(events[i]);
+            } catch (const std::exception& e) {
+                std::cerr << "[RenderPool] Event " << events[i] << ": " << e.what() << std::endl;
+            }
+            send(ok ? Message::kDone : Message::kFailed, i, 1e3 * Seconds(evtStart, Clock::now()));
+        }
+    }
+
+    // skip the destructors of the display, the parent owns the outputs
+    std::cout.flush();
+    _exit(0);
+}
+
+int RenderPool::Run(const std::vector<int>& events, const Setup_t& setup, const Render_t& render)
+{
+    std::vector<int> todo = events;
+    int nDone = 0;
+    while (!todo.empty()) {
+        std::vector<int> unstarted;
+        nDone += RunPass(todo, setup, render, unstarted);
+        // no progress: all workers failed to set up
+        if (unstarted.empty() || unstarted.size() == todo.size()) break;
+        std::cerr << "[RenderPool] Retrying " << unstarted.size() << " events lost with their worker" << std::endl;
+        todo.swap(unstarted);
+    }
+    return events.size() - nDone;
+}
+
+int RenderPool::RunPass(const std::vector<int>& events, const Setup_t& setup, const Render_t& render,
+                        std::vector<int>& unstarted)
+{
+    if (events.empty()) return 0;
+
+    void* shared = mmap(nullptr, sizeof(Queue), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        std::cerr << "[RenderPool] Cannot allocate the work queue" << std::endl;
+        unstarted = events;
+        return 0;
+    }
+    queue = new (shared) Queue();
+    queue->next = 0;
+
+    struct Worker {
+        pid_t pid = -1;
+        int fd = -1;
+        bool ready = false;
+        int current = -1; // event being rendered
+        int64_t next = 0, end = 0; // rest of the claimed chunk, positions in `events`
+        int done = 0, failed = 0;
+        double renderMs = 0;
+        Clock::time_point readyTime, lastTime;
+    };
+    std::vector<Worker> workers(nWorkers_);
+
+    auto spawn = [&](Worker& w) {
+        int fds[2];
+        if (pipe(fds) != 0) return false;
+        std::cout.flush();
+        std::cerr.flush();
+        w.pid = fork();
+        if (w.pid < 0) {
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+        if (w.pid == 0) {
+            close(fds[0]);
+            for (const Worker& o : workers) if (o.fd >= 0) close(o.fd);
+            Work(fds[1], events, setup, render);
+        }
+        close(fds[1]);
+        w.fd = fds[0];
+        return true;
+    };
+
+    const auto start = Clock::now();
+    auto lastReport = start;
+    int nDone = 0, nFailed = 0, nStarted = 0, nAlive = 0;
+    std::vector<char> started(events.size(), 0);
+
+    // the first worker fills the caches, the others only start once it is ready
+    if (spawn(workers[0])) ++nAlive;
+    bool others = false;
+
+    while (nAlive > 0) {
+        if (!others && (workers[0].ready || workers[0].fd < 0)) {
+            others = true;
+            for (int i = 1; i < nWorkers_; ++i) {
+                if (spawn(workers[i])) ++nAlive;
+                else std::cerr << "[RenderPool] Cannot start worker " << i << std::endl;
+            }
+        }
+
+        std::vector<pollfd> fds;
+        std::vector<int> index;
+        for (int i = 0; i < nWorkers_; ++i) {
+            if (workers[i].fd < 0) continue;
+            fds.push_back({workers[i].fd, POLLIN, 0});
+            index.push_back(i);
+        }
+        if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) break;
+
+        for (std::size_t k = 0; k < fds.size(); ++k) {
+            if (!(fds[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            Worker& w = workers[index[k]];
+
+            Message m;
+            ssize_t n = read(w.fd, &m, sizeof(m));
+            if (n == sizeof(m)) {
+                w.lastTime = Clock::now();
+                switch (m.type) {
+                case Message::kReady:
+                    w.ready = true;
+                    w.readyTime = w.lastTime;
+                    std::cout << "[RenderPool] Worker " << index[k] << " ready in " << m.ms << " ms" << std::endl;
+                    break;
+                case Message::kStart:
+                    // chunks start at multiples of chunkSize_
+                    w.current = m.evtID;
+                    w.next = m.index + 1;
+                    w.end = std::min<int64_t>((m.index / chunkSize_ + 1) * chunkSize_, events.size());
+                    started[m.index] = 1;
+                    ++nStarted;
+                    break;
+                case Message::kDone:
+                case Message::kFailed:
+                    w.current = -1;
+                    w.renderMs += m.ms;
+                    if (m.type == Message::kDone) ++w.done, ++nDone;
+                    else ++w.failed, ++nFailed;
+                    break;
+                case Message::kSetupFailed:
+                    std::cerr << "[RenderPool] Worker " << index[k] << " could not set up" << std::endl;
+                    break;
+                }
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+
+            // pipe closed: the worker exited
+            close(w.fd);
+            w.fd = -1;
+            --nAlive;
+            int status = 0;
+            waitpid(w.pid, &status, 0);
+            if (w.current >= 0) {
+                std::cerr << "[RenderPool] Worker " << index[k] << " died while rendering event " << w.current << std::endl;
+                ++w.failed;
+                ++nFailed;
+                if (w.next < w.end) {
+                    std::cerr << "[RenderPool] Worker " << index[k] << " left events unstarted:";
+                    for (int64_t i = w.next; i < w.end; ++i) std::cerr << " " << events[i];
+                    std::cerr << std::endl;
+                }
+            } else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                std::cerr << "[RenderPool] Worker " << index[k] << " exited with status " << status << std::endl;
+            }
+        }
+
+        const auto now = Clock::now();
+        if (Seconds(lastReport, now) >= 5) {
+            lastReport = now;
+            std::cout << "[RenderPool] " << nDone << "/" << events.size() << " events rendered, "
+                      << nFailed << " failed, " << nDone / Seconds(start, now) << " events/s" << std::endl;
+        }
+    }
+
+    const double total = Seconds(start, Clock::now());
+    std::cout << "[RenderPool] Rendered " << nDone << "/" << events.size() << " events with " << nWorkers_
+              << " workers in " << total << " s (" << nDone / total << " events/s), " << nFailed << " failed";
+    if (nStarted < (int) events.size())
+        std::cout << ", " << events.size() - nStarted << " never started";
+    std::cout << std::endl;
+    for (int i = 0; i < nWorkers_; ++i) {
+        const Worker& w = workers[i];
+        const double busy = w.ready ? Seconds(w.readyTime, w.lastTime) : 0;
+        std::cout << "[RenderPool]   worker " << i << ": " << w.done << " events, " << w.failed << " failed, "
+                  << (busy > 0 ? w.done / busy : 0) << " events/s";
+        if (w.done + w.failed > 0) std::cout << ", " << w.renderMs / (w.done + w.failed) << " ms/event";
+        std::cout << std::endl;
+    }
+
+    for (std::size_t i = 0; i < events.size(); ++i)
+        if (!started[i]) unstarted.push_back(events[i]);
+
+    munmap(shared, sizeof(Queue));
+    queue = nullptr;
+    return nDone;
+}
@@ -0,0 +1,136 @@
+#include "StageTimer.hh"
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+StageStats& StageStats::Instance()
+{
+    static StageStats* stats = [] {
+        auto s = new StageStats();
+        if (const char* path = std::getenv("FPFDISPLAY_TIMING_LOG")) s->SetLogFile(path);
+        std::atexit([] {
+            std::string report = StageStats::Instance().GetReport();
+            if (!report.empty()) std::cout << report << std::flush;
+        });
+        return s;
+    }();
+    return *stats;
+}
+
+void StageStats::Record(const std::string& stage, double ms, int evtID)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stage& s = stages_[stage];
+    s.last = ms;
+    s.sum += ms;
+    s.max = std::max(s.max, ms);
+    ++s.count;
+    const int bucket = ms > kMinMs ? int(8 * std::log10(ms / kMinMs)) : 0;
+    ++s.buckets[std::min(bucket, kBuckets - 1)];
+
+    if (log_.is_open()) {
+        const double now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+        log_ << std::fixed << std::setprecision(3)
+             << "{\"time\":" << now << ",\"pid\":" << getpid() << ",\"stage\":\"" << stage << "\""
+             << std::setprecision(4) << ",\"ms\":" << ms;
+        if (evtID >= 0) log_ << ",\"evtID\":" << evtID;
+        log_ << "}\n" << std::flush;
+    }
+}
+
+bool StageStats::SetLogFile(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (log_.is_open()) log_.close();
+    if (path.empty()) return true;
+
+    log_.open(path, std::ios::app);
+    if (!log_) {
+        std::cerr << "[StageStats] Cannot open timing log " << path << std::endl;
+        return false;
+    }
+    std::cout << "[StageStats] Writing stage timings to " << path << std::endl;
+    return true;
+}
+
+double StageStats::GetLast(const std::string& stage) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = stages_.find(stage);
+    return it != stages_.end() ? it->second.last : -1;
+}
+
+std::string StageStats::GetSummary(const std::vector<std::string>& stages) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    for (const std::string& name : stages) {
+        auto it = stages_.find(name);
+        if (it == stages_.end()) continue;
+        if (ss.tellp() > 0) ss << ", ";
+        ss << name << " " << it->second.last << " ms";
+    }
+    return ss.str();
+}
+
+double StageStats::Stage::Percentile(double q) const
+{
+    const double target = q * count;
+    long seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += buckets[i];
+        // upper edge of the bucket, but never above the largest value
+        if (seen >= target) return std::min(max, kMinMs * std::pow(10., (i + 1) / 8.));
+    }
+    return max;
+}
+
+std::string StageStats::GetReport() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stages_.empty()) return "";
+
+    std::ostringstream ss;
+    ss << "[StageStats] Stage latencies (ms):\n" << std::fixed << std::setprecision(2)
+       << "[StageStats] " << std::setw(24) << std::left << "stage" << std::right
+       << std::setw(8) << "count" << std::setw(10) << "mean" << std::setw(10) << "p50"
+       << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+    for (const auto& it : stages_) {
+        const Stage& s = it.second;
+        ss << "[StageStats] " << std::setw(24) << std::left << it.first << std::right
+           << std::setw(8) << s.count << std::setw(10) << s.sum / s.count
+           << std::setw(10) << s.Percentile(0.5) << std::setw(10) << s.Percentile(0.9)
+           << std::setw(10) << s.Percentile(0.99) << std::setw(10) << s.max << "\n";
+    }
+    return ss.str();
+}
+
+std::string StageStats::GetJSON() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream ss;
+    ss << "{";
+    for (auto it = stages_.begin(); it != stages_.end(); ++it) {
+        const Stage& s = it->second;
+        ss << (it == stages_.begin() ? "" : ",") << "\"" << it->first << "\":{\"count\":" << s.count
+           << ",\"total\":" << s.sum << ",\"mean\":" << s.sum / s.count << ",\"p50\":" << s.Percentile(0.5)
+           << ",\"p90\":" << s.Percentile(0.9) << ",\"max\":" << s.max << "}";
+    }
+    ss << "}";
+    return ss.str();
+}
+
+double StageTimer::Stop()
+{
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+    if (!stopped_) {
+        stopped_ = true;
+        StageStats::Instance().Record(stage_, ms, evtID_);
+    }
+    return ms;
+}
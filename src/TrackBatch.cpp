@@ -0,0 +1,393 @@
+#include "TrackBatch.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+#include "TEveManager.h"
+#include "TEveProjectionManager.h"
+#include "TEveProjections.h"
+#include "TEveTrans.h"
+#include "TEveUtil.h"
+#include "TGLSelectRecord.h"
+
+#include "TrackStyle.hh"
+
+ClassImp(TrackBatch)
+ClassImp(TrackBatchProjected)
+
+// ____________________________________________________________________________
+TrackBatch::TrackBatch(const char* name)
+    : TEveElement(), TNamed(name, "")
+{
+    SetMainColorPtr(&fLineColor);
+    fPickable = kTRUE;
+}
+
+// ____________________________________________________________________________
+const std::vector<Float_t>& TrackBatch::GetLODTolerances()
+{
+    // cm: invisible at detector scale, at module scale, at hall scale
+    static const std::vector<Float_t> tolerances = {0.f, 0.05f, 0.5f, 5.f};
+    return tolerances;
+}
+
+// ____________________________________________________________________________
+void TrackBatch::SetTracks(const std::shared_ptr<const EventData>& data, const std::vector<uint32_t>& tracks)
+{
+    Reset();
+    data_ = data;
+    AddTracks(tracks);
+}
+
+// ____________________________________________________________________________
+void TrackBatch::AddTracks(const std::vector<uint32_t>& tracks)
+{
+    const EventData* data = data_.get();
+    const std::size_t nBefore = tracks_.size();
+
+    // order tracks by line style, so each style is drawn with one call
+    // (one per AddTracks call when the batch is filled in chunks)
+    tracks_.insert(tracks_.end(), tracks.begin(), tracks.end());
+    std::stable_sort(tracks_.begin() + nBefore, tracks_.end(), [&](uint32_t a, uint32_t b) {
+        TrackStyle sa = GetTrackStyle(data->pdg[a]), sb = GetTrackStyle(data->pdg[b]);
+        return sa.style != sb.style ? sa.style < sb.style : sa.width < sb.width;
+    });
+
+    std::vector<TrackStyle> styles(tracks_.size() - nBefore);
+    for (std::size_t i = nBefore; i < tracks_.size(); ++i) {
+        const TrackStyle& style = styles[i - nBefore] = GetTrackStyle(data->pdg[tracks_[i]]);
+        if (groups_.empty() || groups_.back().style != style.style || groups_.back().width != style.width)
+            groups_.push_back({style.style, style.width, (Int_t) i, (Int_t) i});
+        groups_.back().end = i + 1;
+    }
+
+    // level 0 takes every point, coarser levels only the points
+    // that RDP keeps at their tolerance
+    if (levels_.empty()) {
+        const bool simplify = data->significance.size() == data->NPoints();
+        for (Float_t tolerance : GetLODTolerances()) {
+            if (tolerance > 0 && !simplify) break;
+            levels_.emplace_back();
+            levels_.back().tolerance = tolerance;
+        }
+    }
+    for (Level& level : levels_) {
+        const Float_t tolerance = level.tolerance;
+        level.first.resize(tracks_.size());
+        level.count.resize(tracks_.size());
+
+        Int_t v = level.vertices.size() / 3;
+        for (std::size_t i = nBefore; i < tracks_.size(); ++i) {
+            const uint32_t t = tracks_[i];
+
+            UChar_t rgba[4];
+            TEveUtil::ColorFromIdx(styles[i - nBefore].color, rgba, kTRUE);
+
+            level.first[i] = v;
+            for (uint32_t k = data->Begin(t); k < data->End(t); ++k) {
+                if (tolerance > 0 && data->significance[k] <= tolerance) continue;
+                level.vertices.insert(level.vertices.end(), {data->x[k], data->y[k], data->z[k]});
+                level.colors.insert(level.colors.end(), rgba, rgba + 4);
+                ++v;
+            }
+            level.count[i] = v - level.first[i];
+        }
+    }
+
+    visible_.resize(tracks_.size(), 1);
+    RebuildDrawLists();
+
+    ResetBBox();
+    StampObjProps();
+}
+
+// ____________________________________________________________________________
+Int_t TrackBatch::SetVisibility(const std::vector<UChar_t>& visible)
+{
+    Int_t changed = 0;
+    for (std::size_t i = 0; i < tracks_.size(); ++i) {
+        const UChar_t v = visible[tracks_[i]] ? 1 : 0;
+        if (v != visible_[i]) {
+            visible_[i] = v;
+            ++changed;
+        }
+    }
+    if (changed == 0) return 0;
+
+    // hidden tracks can not stay selected
+    for (auto it = selectedSet_.begin(); it != selectedSet_.end(); )
+        it = visible_[*it] ? std::next(it) : selectedSet_.erase(it);
+    highlightedSet_.clear();
+
+    RebuildDrawLists();
+    StampObjProps();
+
+    for (auto it = BeginProjecteds(); it != EndProjecteds(); ++it) {
+        if (auto p = dynamic_cast<TrackBatchProjected*>(*it))
+            p->UpdateVisibility();
+    }
+    return changed;
+}
+
+// ____________________________________________________________________________
+void TrackBatch::RebuildDrawLists()
+{
+    drawTracks_.clear();
+    drawGroups_.clear();
+    for (const StyleGroup& g : groups_) {
+        const Int_t begin = drawTracks_.size();
+        for (Int_t i = g.begin; i < g.end; ++i) {
+            if (visible_[i]) drawTracks_.push_back(i);
+        }
+        const Int_t end = drawTracks_.size();
+        if (end > begin) drawGroups_.push_back({g.style, g.width, begin, end});
+    }
+
+    for (Level& level : levels_) {
+        level.drawFirst.resize(drawTracks_.size());
+        level.drawCount.resize(drawTracks_.size());
+        for (std::size_t j = 0; j < drawTracks_.size(); ++j) {
+            level.drawFirst[j] = level.first[drawTracks_[j]];
+            level.drawCount[j] = level.count[drawTracks_[j]];
+        }
+    }
+}
+
+// ____________________________________________________________________________
+Int_t TrackBatch::GetNVertices(Int_t l) const
+{
+    Int_t n = 0;
+    for (Int_t c : levels_[l].drawCount) n += c;
+    return n;
+}
+
+// ____________________________________________________________________________
+void TrackBatch::Reset()
+{
+    levels_.clear();
+    tracks_.clear();
+    groups_.clear();
+    visible_.clear();
+    drawTracks_.clear();
+    drawGroups_.clear();
+    data_.reset();
+    selectedSet_.clear();
+    highlightedSet_.clear();
+    ++generation_;
+
+    ResetBBox();
+    StampObjProps();
+}
+
+// ____________________________________________________________________________
+Int_t TrackBatch::SelectLevel(Float_t pixelSize) const
+{
+    // deviations below half a pixel are invisible
+    const Float_t maxError = 0.5f * pixelSize;
+    for (Int_t l = GetNLevels() - 1; l > 0; --l) {
+        if (levels_[l].tolerance <= maxError) return l;
+    }
+    return 0;
+}
+
+// ____________________________________________________________________________
+void TrackBatch::ProcessGLSelection(TGLSelectRecord& rec)
+{
+    // the first name is the physical shape, the second one our track
+    if (rec.GetN() < 2) return;
+    const Int_t track = rec.GetItem(1);
+    if (track < 0 || track >= GetNTracks() || !visible_[track]) return;
+
+    TrackBatch& owner = GetSelectionOwner();
+    SelectionSet_t& sset = rec.GetHighlight() ? owner.highlightedSet_ : owner.selectedSet_;
+
+    if (rec.GetMultiple()) {
+        if (!sset.insert(track).second) sset.erase(track);
+    } else {
+        sset.clear();
+        sset.insert(track);
+    }
+
+    if (!rec.GetHighlight()) owner.TrackPicked(track);
+
+    owner.StampSelection();
+}
+
+// ____________________________________________________________________________
+void TrackBatch::TrackPicked(Int_t i) const
+{
+    if (!data_) return;
+    const uint32_t t = tracks_[i];
+    std::cout << "[TrackBatch] Track " << data_->tid[t]
+              << ": PDG " << data_->pdg[t]
+              << ", parent " << data_->pid[t]
+              << ", " << data_->kinE[t] << " MeV"
+              << ", " << data_->Size(t) << " points" << std::endl;
+}
+
+// ____________________________________________________________________________
+void TrackBatch::StampSelection()
+{
+    StampColorSelection();
+    for (auto it = BeginProjecteds(); it != EndProjecteds(); ++it)
+        (*it)->GetProjectedAsElement()->StampColorSelection();
+}
+
+// ____________________________________________________________________________
+void TrackBatch::CopyLayout(const TrackBatch& o)
+{
+    levels_.resize(o.levels_.size());
+    for (std::size_t l = 0; l < levels_.size(); ++l) {
+        levels_[l].tolerance = o.levels_[l].tolerance;
+        levels_[l].colors    = o.levels_[l].colors;
+        levels_[l].first     = o.levels_[l].first;
+        levels_[l].count     = o.levels_[l].count;
+    }
+    tracks_  = o.tracks_;
+    groups_  = o.groups_;
+    data_    = o.data_;
+    CopyDrawLists(o);
+}
+
+// ____________________________________________________________________________
+void TrackBatch::CopyDrawLists(const TrackBatch& o)
+{
+    visible_    = o.visible_;
+    drawTracks_ = o.drawTracks_;
+    drawGroups_ = o.drawGroups_;
+    levels_.resize(o.levels_.size());
+    for (std::size_t l = 0; l < levels_.size(); ++l) {
+        levels_[l].drawFirst = o.levels_[l].drawFirst;
+        levels_[l].drawCount = o.levels_[l].drawCount;
+    }
+}
+
+// ____________________________________________________________________________
+void TrackBatch::ComputeBBox()
+{
+    if (levels_.empty() || levels_[0].vertices.empty()) {
+        BBoxZero();
+        return;
+    }
+
+    // simplified levels keep the end points, so lie within the full one
+    const std::vector<Float_t>& v = levels_[0].vertices;
+    BBoxInit();
+    for (std::size_t i = 0; i < v.size(); i += 3)
+        BBoxCheckPoint(v[i], v[i+1], v[i+2]);
+}
+
+// ____________________________________________________________________________
+void TrackBatch::Paint(Option_t*)
+{
+    PaintStandard(this);
+}
+
+// ____________________________________________________________________________
+TClass* TrackBatch::ProjectedClass(const TEveProjection*) const
+{
+    return TrackBatchProjected::Class();
+}
+
+// ____________________________________________________________________________
+TrackBatchProjected::TrackBatchProjected()
+    : TrackBatch(), TEveProjected()
+{}
+
+// ____________________________________________________________________________
+void TrackBatchProjected::SetProjection(TEveProjectionManager* mng, TEveProjectable* model)
+{
+    TEveProjected::SetProjection(mng, model);
+    CopyVizParams(dynamic_cast<TEveElement*>(model));
+}
+
+// ____________________________________________________________________________
+TrackBatch& TrackBatchProjected::GetSelectionOwner()
+{
+    return *dynamic_cast<TrackBatch*>(fProjectable);
+}
+
+// ____________________________________________________________________________
+void TrackBatchProjected::UpdateProjection()
+{
+    // called by TEve when the projection changes too: everything is
+    // projected again, reusing the buffers of the previous event
+    Project(0);
+}
+
+// ____________________________________________________________________________
+void TrackBatchProjected::ProjectAppended()
+{
+    // same event: the tracks projected so far are still valid
+    const TrackBatch& orig = *dynamic_cast<TrackBatch*>(fProjectable);
+    const bool appended = projectedGeneration_ == orig.generation_ && tracks_.size() <= orig.tracks_.size();
+    Project(appended ? tracks_.size() : 0);
+}
+
+// ____________________________________________________________________________
+void TrackBatchProjected::Project(std::size_t nDone)
+{
+    TEveProjection& proj = *fManager->GetProjection();
+    TrackBatch& orig = *dynamic_cast<TrackBatch*>(fProjectable);
+    TEveTrans* tr = orig.PtrMainTrans(kFALSE);
+
+    projectedGeneration_ = orig.generation_;
+    CopyLayout(orig);
+    if (levels_.empty()) {
+        ResetBBox();
+        StampObjProps();
+        return;
+    }
+
+    // end of the vertices of the tracks kept, in a level
+    auto kept = [nDone](const Level& level) {
+        return nDone > 0 ? 3 * std::size_t(level.first[nDone-1] + level.count[nDone-1]) : 0;
+    };
+
+    // each point is projected once, in the full level...
+    const std::vector<Float_t>& in = orig.GetLevel(0).vertices;
+    std::vector<Float_t>& full = levels_[0].vertices;
+    const std::size_t from = kept(levels_[0]);
+    full.resize(in.size());
+    for (std::size_t i = from; i < in.size(); i += 3)
+        proj.ProjectPointfv(tr, &in[i], &full[i], fDepth);
+
+    // ...the simplified levels pick the points they keep from it
+    for (std::size_t l = 1; l < levels_.size(); ++l) {
+        const Float_t tolerance = levels_[l].tolerance;
+        std::vector<Float_t>& out = levels_[l].vertices;
+        out.resize(orig.GetLevel(l).vertices.size());
+        Float_t* o = out.data() + kept(levels_[l]);
+        for (std::size_t i = nDone; i < tracks_.size(); ++i) {
+            const uint32_t t = tracks_[i];
+            const Float_t* v = full.data() + 3 * levels_[0].first[i];
+            for (uint32_t k = data_->Begin(t); k < data_->End(t); ++k, v += 3) {
+                if (data_->significance[k] <= tolerance) continue;
+                o[0] = v[0]; o[1] = v[1]; o[2] = v[2];
+                o += 3;
+            }
+        }
+    }
+
+    ResetBBox();
+    StampObjProps();
+}
+
+// ____________________________________________________________________________
+void TrackBatchProjected::UpdateVisibility()
+{
+    CopyDrawLists(GetSelectionOwner());
+    StampObjProps();
+}
+
+// ____________________________________________________________________________
+void TrackBatchProjected::SetDepthLocal(Float_t d)
+{
+    SetDepthCommon(d, this, fBBox);
+
+    for (auto& level : levels_) {
+        for (std::size_t i = 2; i < level.vertices.size(); i += 3)
+            level.vertices[i] = fDepth;
+    }
+}
@@ -0,0 +1,148 @@
+#include "TrackBatchGL.hh"
+
+#include <cmath>
+
+#include "TGLIncludes.h"
+#include "TGLCamera.h"
+#include "TGLRnrCtx.h"
+#include "TGLSelectRecord.h"
+#include "TGLUtil.h"
+
+ClassImp(TrackBatchGL)
+
+namespace {
+    // same patterns as TGLUtil::BeginAttLine
+    UShort_t StipplePattern(Style_t style)
+    {
+        switch (style) {
+            case 2:  return 0x3333;
+            case 3:  return 0x5555;
+            case 4:  return 0xf040;
+            case 5:  return 0xf4f4;
+            case 6:  return 0xf111;
+            case 7:  return 0xf0f0;
+            case 8:  return 0xff11;
+            case 9:  return 0x3fff;
+            case 10: return 0x08ff;
+            default: return 0xffff;
+        }
+    }
+}
+
+// ____________________________________________________________________________
+TrackBatchGL::TrackBatchGL()
+    : TGLObject(), model_(nullptr), highlightSet_(nullptr)
+{
+    fMultiColor = kTRUE;
+}
+
+// ____________________________________________________________________________
+Bool_t TrackBatchGL::SetModel(TObject* obj, const Option_t*)
+{
+    model_ = SetModelDynCast<TrackBatch>(obj);
+    return model_ != nullptr;
+}
+
+// ____________________________________________________________________________
+void TrackBatchGL::SetBBox()
+{
+    SetAxisAlignedBBox(model_->AssertBBox());
+}
+
+// ____________________________________________________________________________
+Bool_t TrackBatchGL::ShouldDLCache(const TGLRnrCtx&) const
+{
+    // the level of detail follows the camera of each viewer, and the
+    // highlight and selection passes only draw a subset of the tracks
+    return kFALSE;
+}
+
+// ____________________________________________________________________________
+Int_t TrackBatchGL::SelectLevel(TGLRnrCtx& rnrCtx) const
+{
+    // world size of one pixel around the centre of the tracks
+    TGLVector3 d = rnrCtx.RefCamera().ViewportDeltaToWorld(fBoundingBox.Center(), 1, 0);
+    const Double_t pixel = d.Mag();
+    if (!(pixel > 0) || !std::isfinite(pixel)) return 0;
+    return model_->SelectLevel(pixel);
+}
+
+// ____________________________________________________________________________
+void TrackBatchGL::DirectDraw(TGLRnrCtx& rnrCtx) const
+{
+    const TrackBatch& m = *model_;
+    if (m.GetNVisible() == 0) return;
+
+    const TrackBatch::Level& level = m.GetLevel(SelectLevel(rnrCtx));
+    const Int_t* first = level.first.data();
+    const Int_t* count = level.count.data();
+
+    glPushAttrib(GL_ENABLE_BIT | GL_LINE_BIT);
+    glDisable(GL_LIGHTING);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, level.vertices.data());
+
+    if (rnrCtx.SecSelection()) {
+        // one name per visible track, for picking
+        TGLUtil::LineWidth(m.GetLineWidth());
+        for (Int_t i : m.GetDrawTracks()) {
+            glPushName(i);
+            glDrawArrays(GL_LINE_STRIP, first[i], count[i]);
+            glPopName();
+        }
+    }
+    else if (highlightSet_) {
+        // colour is set by the highlight pass
+        TGLUtil::LineWidth(m.GetLineWidth() + 2);
+        for (Int_t i : *highlightSet_) {
+            if (i < m.GetNTracks() && m.IsVisible(i))
+                glDrawArrays(GL_LINE_STRIP, first[i], count[i]);
+        }
+    }
+    else {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(4, GL_UNSIGNED_BYTE, 0, level.colors.data());
+
+        const Int_t* drawFirst = level.drawFirst.data();
+        const Int_t* drawCount = level.drawCount.data();
+        for (const auto& g : m.GetDrawGroups()) {
+            TGLUtil::LineWidth(g.width);
+            if (g.style > 1) {
+                glLineStipple(1, StipplePattern(g.style));
+                glEnable(GL_LINE_STIPPLE);
+            } else {
+                glDisable(GL_LINE_STIPPLE);
+            }
+            glMultiDrawArrays(GL_LINE_STRIP, drawFirst + g.begin, drawCount + g.begin, g.end - g.begin);
+        }
+
+        glDisableClientState(GL_COLOR_ARRAY);
+    }
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glPopAttrib();
+}
+
+// ____________________________________________________________________________
+void TrackBatchGL::DrawHighlight(TGLRnrCtx& rnrCtx, const TGLPhysicalShape* pshp, Int_t lvl) const
+{
+    // only draw the picked tracks, selection state lives in the original
+    // batch so that it is shared by the 3D and projected views
+    TrackBatch& owner = model_->GetSelectionOwner();
+
+    if (!owner.RefHighlightedSet().empty()) {
+        highlightSet_ = &owner.RefHighlightedSet();
+        TGLObject::DrawHighlight(rnrCtx, pshp, lvl);
+    }
+    if (!owner.RefSelectedSet().empty()) {
+        highlightSet_ = &owner.RefSelectedSet();
+        TGLObject::DrawHighlight(rnrCtx, pshp, lvl);
+    }
+    highlightSet_ = nullptr;
+}
+
+// ____________________________________________________________________________
+void TrackBatchGL::ProcessSelection(TGLRnrCtx&, TGLSelectRecord& rec)
+{
+    model_->ProcessGLSelection(rec);
+}
@@ -0,0 +1,54 @@
+#include "TrackQuantities.hh"
+
+#include <cmath>
+
+void ComputeTrackQuantities(EventData& data)
+{
+    const std::size_t nTracks = data.NTracks();
+    data.length.resize(nTracks);
+    data.displacement.resize(nTracks);
+    data.xmin.resize(nTracks);
+    data.xmax.resize(nTracks);
+    data.ymin.resize(nTracks);
+    data.ymax.resize(nTracks);
+    data.zmin.resize(nTracks);
+    data.zmax.resize(nTracks);
+
+    const float* __restrict x = data.x.data();
+    const float* __restrict y = data.y.data();
+    const float* __restrict z = data.z.data();
+
+    for (std::size_t t = 0; t < nTracks; ++t) {
+        const std::size_t b = data.Begin(t), e = data.End(t);
+        if (b == e) {
+            data.length[t] = data.displacement[t] = 0;
+            data.xmin[t] = data.xmax[t] = data.ymin[t] = data.ymax[t] = data.zmin[t] = data.zmax[t] = 0;
+            continue;
+        }
+
+        // polyline length: sum of the segments (k, k+1)
+        float len = 0;
+        for (std::size_t k = b; k < e - 1; ++k) {
+            const float dx = x[k+1] - x[k], dy = y[k+1] - y[k], dz = z[k+1] - z[k];
+            len += std::sqrt(dx*dx + dy*dy + dz*dz);
+        }
+
+        // bounding box
+        float x0 = x[b], x1 = x[b], y0 = y[b], y1 = y[b], z0 = z[b], z1 = z[b];
+        for (std::size_t k = b + 1; k < e; ++k) {
+            x0 = x[k] < x0 ? x[k] : x0;
+            x1 = x[k] > x1 ? x[k] : x1;
+            y0 = y[k] < y0 ? y[k] : y0;
+            y1 = y[k] > y1 ? y[k] : y1;
+            z0 = z[k] < z0 ? z[k] : z0;
+            z1 = z[k] > z1 ? z[k] : z1;
+        }
+
+        const float dx = x[e-1] - x[b], dy = y[e-1] - y[b], dz = z[e-1] - z[b];
+        data.length[t] = len;
+        data.displacement[t] = std::sqrt(dx*dx + dy*dy + dz*dz);
+        data.xmin[t] = x0; data.xmax[t] = x1;
+        data.ymin[t] = y0; data.ymax[t] = y1;
+        data.zmin[t] = z0; data.zmax[t] = z1;
+    }
+}
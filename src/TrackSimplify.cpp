@@ -0,0 +1,94 @@
+#include "TrackSimplify.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    // events with fewer points are not worth spawning threads for
+    const std::size_t kParallelMinPoints = 100000;
+
+    struct Segment {
+        uint32_t i0, i1;
+        float    parentSig;
+    };
+
+    // distance of point p from segment [a, b]
+    float SegmentDistance(const EventData& d, uint32_t p, uint32_t a, uint32_t b)
+    {
+        const float abx = d.x[b] - d.x[a], aby = d.y[b] - d.y[a], abz = d.z[b] - d.z[a];
+        const float apx = d.x[p] - d.x[a], apy = d.y[p] - d.y[a], apz = d.z[p] - d.z[a];
+        const float len2 = abx*abx + aby*aby + abz*abz;
+
+        float t = len2 > 0 ? (apx*abx + apy*aby + apz*abz) / len2 : 0;
+        t = std::min(1.f, std::max(0.f, t));
+
+        const float dx = apx - t*abx, dy = apy - t*aby, dz = apz - t*abz;
+        return std::sqrt(dx*dx + dy*dy + dz*dz);
+    }
+
+    // full RDP subdivision of one track: the significance of the split
+    // point is its distance, capped by the significance of the parent
+    // segment, since RDP never splits a segment it has not reached
+    void TrackSignificance(EventData& d, std::size_t track, std::vector<Segment>& stack)
+    {
+        const uint32_t b = d.Begin(track), e = d.End(track);
+        if (b == e) return;
+
+        d.significance[b] = FLT_MAX;
+        d.significance[e-1] = FLT_MAX;
+
+        stack.clear();
+        stack.push_back({b, e-1, FLT_MAX});
+        while (!stack.empty()) {
+            const Segment s = stack.back();
+            stack.pop_back();
+            if (s.i1 - s.i0 < 2) continue;
+
+            uint32_t kmax = s.i0 + 1;
+            float dmax = -1;
+            for (uint32_t k = s.i0 + 1; k < s.i1; ++k) {
+                const float dist = SegmentDistance(d, k, s.i0, s.i1);
+                if (dist > dmax) { dmax = dist; kmax = k; }
+            }
+
+            const float sig = std::min(dmax, s.parentSig);
+            d.significance[kmax] = sig;
+            stack.push_back({s.i0, kmax, sig});
+            stack.push_back({kmax, s.i1, sig});
+        }
+    }
+
+    void Range(EventData& d, std::size_t begin, std::size_t end)
+    {
+        std::vector<Segment> stack;
+        for (std::size_t t = begin; t < end; ++t) TrackSignificance(d, t, stack);
+    }
+}
+
+void ComputeSignificance(EventData& data)
+{
+    data.significance.assign(data.NPoints(), 0.f);
+
+    const std::size_t nTracks = data.NTracks();
+    const unsigned nThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (nThreads == 1 || data.NPoints() < kParallelMinPoints) {
+        Range(data, 0, nTracks);
+        return;
+    }
+
+    // tracks write disjoint ranges of the significance column: no locking.
+    // Interleave small blocks of tracks to balance long and short ones
+    const std::size_t block = 64;
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < nThreads; ++w) {
+        workers.emplace_back([&data, w, nThreads, nTracks, block] {
+            for (std::size_t b = w * block; b < nTracks; b += nThreads * block)
+                Range(data, b, std::min(nTracks, b + block));
+        });
+    }
+    for (auto& w : workers) w.join();
+}
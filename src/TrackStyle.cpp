@@ -0,0 +1,42 @@
+#include "TrackStyle.hh"
+
+#include "TColor.h"
+
+TrackStyle GetTrackStyle(int pdg)
+{
+    switch(pdg){
+        // gamma
+        case 22:
+            return {kGray, 10, 1};
+
+        // e+/e-
+        case 11:
+        case -11:
+            return {kRed, 1, 1};
+
+        // mu+/mu-
+        case 13:
+        case -13:
+            return {kBlue+1, 1, 1};
+
+        // proton
+        case 2212:
+            return {kBlack, 1, 1};
+
+        // neutron
+        case 2112:
+            return {kOrange, 7, 1};
+
+        // pion0
+        case 111:
+            return {kMagenta, 7, 1};
+
+        // pion+/pion-
+        case 211:
+        case -211:
+            return {kCyan, 1, 1};
+
+        default:
+            return {8, 1, 1};
+    }
+}